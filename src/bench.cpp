@@ -0,0 +1,434 @@
+//
+// Microbenchmarks for the CPU side of the samples, no window or GL context needed
+//
+// Build native:
+//     g++ -std=c++11 -O2 bench.cpp bitexpand.cpp glstate.cpp texfont.cpp sdf.cpp checkerfill.cpp mipmap.cpp -I<SDL2 include dir> -lGLESv2 -pthread -o bench
+//
+// Build web (add -msimd128 for the WASM SIMD backends):
+//     emcc -std=c++11 -O2 -msimd128 bench.cpp bitexpand.cpp glstate.cpp texfont.cpp sdf.cpp checkerfill.cpp mipmap.cpp -s USE_SDL=2 -s WASM=1 --preload-file media/rockfont.txf -o bench.html
+//
+// Run:
+//     ./bench  (or emrun bench.html)
+//
+// Result:
+//     Throughput per benchmark and backend, with results checked against the reference code.
+//
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "bitexpand.h"
+#include "checkerfill.h"
+#include "mipmap.h"
+#include "sdf.h"
+#include "texfont.h"
+
+// Seconds per call of fn, averaged over enough iterations to run for at least minSeconds
+template <typename Fn>
+double timeIt(Fn fn, double minSeconds = 0.25)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    fn(); // Warm up
+    int iterations = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do
+    {
+        fn();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed / iterations;
+}
+
+// Reference TXF_FORMAT_BITMAP expansion, as originally written in txfLoadFont
+void bitExpandReference(const unsigned char* texbitmap, int stride, unsigned char* teximage, int width, int height)
+{
+    for (int i = 0; i < height; i++) 
+    {
+        for (int j = 0; j < width; j++) 
+        {
+            if (texbitmap[i * stride + (j >> 3)] & (1 << (j & 7))) 
+                teximage[i * width + j] = 255;
+            else
+                teximage[i * width + j] = 0;
+        }
+    }
+}
+
+void benchBitExpand(int width, int height)
+{
+    int stride = (width + 7) >> 3;
+    std::vector<unsigned char> bitmap(stride * height), reference(width * height), texels(width * height);
+    srand(1);
+    for (size_t i = 0; i < bitmap.size(); ++i)
+        bitmap[i] = (unsigned char)rand();
+
+    printf("bitExpand %dx%d\n", width, height);
+    double mb = width * height / (1024.0 * 1024.0);
+    double seconds = timeIt([&]() { bitExpandReference(&bitmap[0], stride, &reference[0], width, height); });
+    printf("    %-10s %10.1f MB/s\n", "reference", mb / seconds);
+
+    for (int backend = 0; backend < BIT_EXPAND_BACKENDS; ++backend)
+    {
+        if (!bitExpandBackendAvailable((BitExpandBackend)backend))
+            continue;
+        memset(&texels[0], 0x5a, texels.size());
+        seconds = timeIt([&]() { bitExpand(&bitmap[0], stride, &texels[0], width, height, (BitExpandBackend)backend); });
+        bool exact = memcmp(&texels[0], &reference[0], texels.size()) == 0;
+        printf("    %-10s %10.1f MB/s  %s\n", bitExpandBackendName((BitExpandBackend)backend), mb / seconds,
+               exact ? "bit-exact" : "MISMATCH");
+    }
+}
+
+// Glyph quad building for long strings, CPU only (the batch is never flushed)
+void benchTxfStrings(const char* fontName)
+{
+    TexFont* txf = txfLoadFont(fontName);
+    if (!txf)
+        return;
+
+    printf("txfBatchString %s\n", fontName);
+    TxfTextBatch* batch = txfCreateTextBatch(txf);
+    const int lengths[] = {64, 1024, 16384};
+    for (int length : lengths)
+    {
+        std::string text;
+        while ((int)text.size() < length)
+            text += "Text OpenGL 3D ";
+        text.resize(length);
+
+        double seconds = timeIt([&]() { txfBeginTextBatch(batch); txfBatchString(batch, text.c_str(), 0.0f, 0.0f); });
+        int glyphs = batch->vertices.size() / 4;
+        printf("    %6d chars %8.1f ns/glyph %6.1f bytes/glyph\n", length, seconds * 1e9 / glyphs,
+               batch->vertices.size() * sizeof(TxfGlyphVertex) / (double)glyphs);
+    }
+    txfDestroyTextBatch(batch);
+    txfUnloadFont(txf);
+}
+
+// Word wrapped layout of a large corpus, first with cold then with warm width caches
+void benchTxfLayout(const char* fontName)
+{
+    TexFont* txf = txfLoadFont(fontName);
+    if (!txf)
+        return;
+
+    const char* words[] = {"Text", "OpenGL", "3D", "Mesa", "Stack", "Token", "Pane", "Dense", "GL", "Axes", "Next"};
+    const int numWords = sizeof(words) / sizeof(words[0]);
+    std::string corpus;
+    srand(1);
+    for (int i = 0; i < 200000; ++i)
+    {
+        corpus += words[rand() % numWords];
+        corpus += (i % 997 == 996) ? "\n\n" : (i % 97 == 96) ? "\n" : " ";  // Paragraphs, blank line between
+    }
+
+    printf("txfLayoutText %d KB corpus\n", (int)(corpus.size() / 1024));
+    TxfLayout layout;
+
+    // Blank lines take up a line's height and hold no glyphs
+    txfLayoutText(txf, "Text\n\nGL", 0.0f, TXF_ALIGN_LEFT, &layout);
+    bool blankOk = layout.lines == 3 && layout.vertices.size() == 6 * 4;
+    printf("    blank line %d lines %d glyphs  %s\n", layout.lines, (int)(layout.vertices.size() / 4),
+           blankOk ? "as expected" : "MISMATCH");
+
+    const TxfAlign aligns[] = {TXF_ALIGN_LEFT, TXF_ALIGN_CENTER, TXF_ALIGN_RIGHT};
+    const char* alignNames[] = {"left", "center", "right"};
+    for (int i = 0; i < 3; ++i)
+    {
+        txf->widths.clear();
+        typedef std::chrono::high_resolution_clock Clock;
+        Clock::time_point start = Clock::now();
+        txfLayoutText(txf, corpus.c_str(), 640.0f, aligns[i], &layout);
+        double coldSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        double warmSeconds = timeIt([&]() { txfLayoutText(txf, corpus.c_str(), 640.0f, aligns[i], &layout); });
+
+        double glyphs = layout.vertices.size() / 4;
+        printf("    %-6s %6d lines %8.1f Mglyphs/s cold %8.1f Mglyphs/s warm\n", alignNames[i], layout.lines,
+               glyphs / coldSeconds / 1e6, glyphs / warmSeconds / 1e6);
+    }
+    txfUnloadFont(txf);
+}
+
+// Signed distance field generation from a font atlas, linear in the texel count
+void benchSdf(const char* fontName, int spread)
+{
+    TexFont* txf = txfLoadFont(fontName);
+    if (!txf)
+        return;
+
+    int width = txf->tex_width, height = txf->tex_height;
+    std::vector<unsigned char> field(width * height);
+    double seconds = timeIt([&]() { sdfGenerate(txf->teximage, width, &field[0], width, width, height, spread); });
+    printf("sdfGenerate %s %dx%d spread %d\n", fontName, width, height, spread);
+    printf("    %8.2f ms %8.1f Mtexels/s\n", seconds * 1e3, width * height / seconds / 1e6);
+    txfUnloadFont(txf);
+}
+
+int nextPowerOfTwo(int val)
+{
+    int power = 1;
+    while (power < val)
+        power *= 2;
+    return power;
+}
+
+// hello_text_ttf text texture as originally built: 8-bit text converted to RGBA, blitted
+// into a cleared power of 2 RGBA texture, then every texel's alpha patched
+void textTextureReference(const unsigned char* text, int width, int height, const unsigned int* palette,
+                          std::vector<unsigned int>& rgba, std::vector<unsigned int>& texture, int texWidth, int texHeight)
+{
+    for (int i = 0; i < width * height; ++i)
+        rgba[i] = palette[text[i]];
+    memset(&texture[0], 0x0, texWidth * texHeight * 4);
+    for (int row = 0; row < height; ++row)
+        memcpy(&texture[(texHeight - height - 1 + row) * texWidth + 1], &rgba[row * width], width * 4);
+    for (int i = 0; i < texWidth * texHeight; ++i)
+    {
+        if (texture[i] != 0)
+            texture[i] |= 0xff000000;
+        else
+            texture[i] = 0x80808080;
+    }
+}
+
+// As hello_text_ttf now builds it: 8-bit text straight to a power of 2 GL_ALPHA texture
+void textTextureDirect(const unsigned char* text, int width, int height,
+                       std::vector<unsigned char>& texture, int texWidth, int texHeight)
+{
+    texture.assign(texWidth * texHeight, 0);
+    unsigned char* dst = &texture[(texHeight - height - 1) * texWidth + 1];
+    for (int row = 0; row < height; ++row)
+        for (int col = 0; col < width; ++col)
+            dst[row * texWidth + col] = text[row * width + col] ? 0xff : 0x00;
+}
+
+// Text texture building from synthetic TTF_RenderText_Solid output (no SDL_ttf needed)
+void benchTextTexture(int width, int height)
+{
+    std::vector<unsigned char> text(width * height);
+    srand(1);
+    for (size_t i = 0; i < text.size(); ++i)
+        text[i] = (rand() % 3) == 0;
+    const unsigned int palette[256] = {0x00000000, 0xffffffff};
+
+    int texWidth = nextPowerOfTwo(width + 2), texHeight = nextPowerOfTwo(height + 2);
+    std::vector<unsigned int> rgba(width * height), reference(texWidth * texHeight);
+    std::vector<unsigned char> texture;
+
+    printf("text texture %dx%d text in %dx%d texture\n", width, height, texWidth, texHeight);
+    double seconds = timeIt([&]() { textTextureReference(&text[0], width, height, palette, rgba, reference, texWidth, texHeight); });
+    printf("    %-10s %8.1f us %8d texture bytes\n", "reference", seconds * 1e6, texWidth * texHeight * 4);
+    seconds = timeIt([&]() { textTextureDirect(&text[0], width, height, texture, texWidth, texHeight); });
+
+    // Same texels: opaque white text where alpha is 1, translucent gray where 0
+    bool same = true;
+    for (int i = 0; i < texWidth * texHeight; ++i)
+        same = same && (reference[i] == (texture[i] ? 0xffffffff : 0x80808080));
+    printf("    %-10s %8.1f us %8d texture bytes  %s\n", "direct", seconds * 1e6, texWidth * texHeight,
+           same ? "same texels" : "MISMATCH");
+}
+
+// hello_image background pixel as originally written, one call per pixel
+unsigned int checkerPixelReference(int x, int y, int width, int height)
+{
+    if (y == 0 || x == 0 || y == height - 1 || x == width - 1)
+        return 0xff00ffff; // yellow
+
+    const int checkerSize = 100, halfChecker = checkerSize / 2,
+            yMod = y % checkerSize, xMod = x % checkerSize;
+    if ((yMod < halfChecker && xMod < halfChecker) 
+        || (yMod >= halfChecker && xMod >= halfChecker))
+        return 0xffc4c4c4; // light grey
+    else
+        return 0xff808080; // dark grey
+}
+
+// hello_image background fill, whole images and an offset region
+void benchCheckerFill(int width, int height)
+{
+    const CheckerImage image = {width, height, 100, 0xff00ffff, 0xffc4c4c4, 0xff808080};
+    std::vector<unsigned int> reference(width * height), pixels(width * height);
+
+    printf("checkerFill %dx%d\n", width, height);
+    double mpixels = width * height / 1e6;
+    double seconds = timeIt([&]() {
+        unsigned int* dst = &reference[0];
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                *dst++ = checkerPixelReference(x, y, width, height);
+    });
+    printf("    %-14s %10.1f Mpixels/s\n", "reference", mpixels / seconds);
+
+    int maxThreads = checkerFillMaxThreads();
+    for (int backend = 0; backend < CHECKER_FILL_BACKENDS; ++backend)
+    {
+        if (!checkerFillBackendAvailable((CheckerFillBackend)backend))
+            continue;
+        for (int threads = 1; threads <= maxThreads; threads = threads < maxThreads ? maxThreads : threads + 1)
+        {
+            memset(&pixels[0], 0x5a, pixels.size() * sizeof(unsigned int));
+            seconds = timeIt([&]() { checkerFill(&image, 0, 0, width, height, &pixels[0], (CheckerFillBackend)backend, threads); });
+            bool exact = memcmp(&pixels[0], &reference[0], pixels.size() * sizeof(unsigned int)) == 0;
+
+            // A region off the origin, as resizing uploads, starts runs mid checker
+            int regionX = width / 3, regionY = height / 3, regionWidth = width - regionX, regionHeight = height - regionY;
+            checkerFill(&image, regionX, regionY, regionWidth, regionHeight, &pixels[0], (CheckerFillBackend)backend, threads);
+            for (int y = 0; y < regionHeight && exact; ++y)
+                exact = memcmp(&pixels[y * regionWidth], &reference[(regionY + y) * width + regionX],
+                               regionWidth * sizeof(unsigned int)) == 0;
+
+            char name[32];
+            snprintf(name, sizeof(name), "%s x%d", checkerFillBackendName((CheckerFillBackend)backend), threads);
+            printf("    %-14s %10.1f Mpixels/s  %s\n", name, mpixels / seconds, exact ? "same pixels" : "MISMATCH");
+        }
+    }
+}
+
+// Mipmap chain building, RGBA and ALPHA texels
+void benchMipmap(int width, int height, int components)
+{
+    std::vector<unsigned char> image(width * height * components);
+    srand(1);
+    for (size_t i = 0; i < image.size(); ++i)
+        image[i] = (unsigned char)rand();
+
+    // Whole chain below level 0, levels packed one after another
+    int levels = mipmapLevels(width, height);
+    size_t chainBytes = 0;
+    for (int level = 1, w = width, h = height; level < levels; ++level)
+    {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        chainBytes += w * h * components;
+    }
+    std::vector<unsigned char> reference(chainBytes), chain(chainBytes);
+    auto buildChain = [&](unsigned char* dst, MipmapBackend backend) {
+        const unsigned char* src = &image[0];
+        for (int level = 1, w = width, h = height; level < levels; ++level)
+        {
+            mipmapDownsample(src, w, h, components, dst, backend);
+            src = dst;
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+            dst += w * h * components;
+        }
+    };
+
+    printf("mipmap %dx%d, %d byte texels, %d levels\n", width, height, components, levels);
+    double mb = image.size() / (1024.0 * 1024.0);
+    buildChain(&reference[0], MIPMAP_SCALAR);
+    for (int backend = 0; backend < MIPMAP_BACKENDS; ++backend)
+    {
+        if (!mipmapBackendAvailable((MipmapBackend)backend))
+            continue;
+        memset(&chain[0], 0x5a, chain.size());
+        double seconds = timeIt([&]() { buildChain(&chain[0], (MipmapBackend)backend); });
+        bool exact = memcmp(&chain[0], &reference[0], chain.size()) == 0;
+        printf("    %-10s %10.1f MB/s  %s\n", mipmapBackendName((MipmapBackend)backend), mb / seconds,
+               exact ? "bit-exact" : "MISMATCH");
+    }
+}
+
+// Texels a software sampler fetches drawing a size x size RGBA texture on a square quad
+// scaled by zoom, as hello_texture does between cZoomMin and its largest zoom. Bilinear
+// filtering reads 4 texels of level 0 per pixel, trilinear 4 from each of the two levels
+// nearest the pixel footprint. Distinct texels and 64 byte cache lines show the working set.
+void benchTexelFootprint(int size, const float* zooms, int zoomCount)
+{
+    int levels = mipmapLevels(size, size);
+    std::vector<size_t> levelOffset(levels + 1, 0);
+    for (int level = 0; level < levels; ++level)
+    {
+        int levelSize = size >> level;
+        levelOffset[level + 1] = levelOffset[level] + levelSize * levelSize;
+    }
+
+    printf("texel footprint %dx%d RGBA\n", size, size);
+    printf("    %-6s %-10s %12s %14s %12s\n", "zoom", "filter", "fetches", "texels", "cache lines");
+    for (int z = 0; z < zoomCount; ++z)
+    {
+        int quad = (int)(size * zooms[z] + 0.5f);
+        float lambda = log2f((float)size / quad);
+        for (int trilinear = 0; trilinear <= 1; ++trilinear)
+        {
+            std::vector<bool> texelRead(levelOffset[levels]), lineRead(levelOffset[levels] * 4 / 64 + 1);
+            size_t fetches = 0, texels = 0, lines = 0;
+            auto fetch = [&](int level, int x, int y) {
+                int levelSize = size >> level;
+                x = x < 0 ? 0 : x >= levelSize ? levelSize - 1 : x;
+                y = y < 0 ? 0 : y >= levelSize ? levelSize - 1 : y;
+                size_t texel = levelOffset[level] + y * levelSize + x;
+                ++fetches;
+                if (!texelRead[texel])
+                {
+                    texelRead[texel] = true;
+                    ++texels;
+                }
+                if (!lineRead[texel * 4 / 64])
+                {
+                    lineRead[texel * 4 / 64] = true;
+                    ++lines;
+                }
+            };
+            auto bilinear = [&](int level, float u, float v) {
+                int levelSize = size >> level;
+                int x = (int)floorf(u * levelSize - 0.5f), y = (int)floorf(v * levelSize - 0.5f);
+                fetch(level, x, y);
+                fetch(level, x + 1, y);
+                fetch(level, x, y + 1);
+                fetch(level, x + 1, y + 1);
+            };
+
+            int level0 = 0, level1 = 0;
+            if (trilinear && lambda > 0.0f)
+            {
+                level0 = (int)lambda < levels - 1 ? (int)lambda : levels - 1;
+                level1 = level0 + 1 < levels && lambda > (float)level0 ? level0 + 1 : level0;
+            }
+            for (int y = 0; y < quad; ++y)
+            {
+                for (int x = 0; x < quad; ++x)
+                {
+                    float u = (x + 0.5f) / quad, v = (y + 0.5f) / quad;
+                    bilinear(level0, u, v);
+                    if (level1 != level0)
+                        bilinear(level1, u, v);
+                }
+            }
+            printf("    %-6.2f %-10s %12zu %14zu %12zu\n", zooms[z], trilinear ? "trilinear" : "bilinear",
+                   fetches, texels, lines);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    benchBitExpand(2048, 2048);
+    benchBitExpand(1021, 67); // Odd width exercises the partial byte tails
+
+    benchTxfStrings("media/rockfont.txf");
+    benchTxfLayout("media/rockfont.txf");
+    benchSdf("media/rockfont.txf", 4);
+
+    benchTextTexture(330, 75);   // "Hello Text" at 64 points
+    benchTextTexture(1500, 300);
+
+    benchCheckerFill(640, 480);
+    benchCheckerFill(1920, 1080);
+    benchCheckerFill(3840, 2160);
+
+    benchMipmap(2048, 2048, 4);
+    benchMipmap(2048, 2048, 1);
+    benchMipmap(1021, 67, 4); // Odd sizes exercise the scalar tails
+
+    const float zooms[] = {2.0f, 1.0f, 0.5f, 0.25f, 0.1f}; // hello_texture zooms, down to cZoomMin
+    benchTexelFootprint(512, zooms, sizeof(zooms) / sizeof(zooms[0]));
+
+    return 0;
+}
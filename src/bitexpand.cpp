@@ -0,0 +1,170 @@
+//
+// Expansion of 1 bit per texel bitmaps to 8 bits per texel
+//
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#define BIT_EXPAND_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BIT_EXPAND_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(__wasm_simd128__)
+#define BIT_EXPAND_HAVE_SIMD128 1
+#include <wasm_simd128.h>
+#endif
+#include "bitexpand.h"
+
+// 8 expanded texels for every possible source byte
+struct BitExpandTable
+{
+    uint64_t texels[256];
+
+    BitExpandTable()
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            unsigned char expanded[8];
+            for (int j = 0; j < 8; ++j)
+                expanded[j] = (b & (1 << j)) ? 255 : 0;
+            memcpy(&texels[b], expanded, 8);
+        }
+    }
+};
+
+static const BitExpandTable cBitExpandTable;
+
+// Expand the remaining texels of a row, starting at source byte firstByte
+static void expandRowTail(const unsigned char* src, unsigned char* dst, int width, int firstByte)
+{
+    int fullBytes = width >> 3;
+    for (int i = firstByte; i < fullBytes; ++i)
+        memcpy(dst + i * 8, &cBitExpandTable.texels[src[i]], 8);
+    for (int j = fullBytes * 8; j < width; ++j)
+        dst[j] = (src[j >> 3] & (1 << (j & 7))) ? 255 : 0;
+}
+
+#ifdef BIT_EXPAND_HAVE_SSE2
+// 16 source bytes to 128 texels: replicate each byte 8 times with unpacks, then test its bits
+static void expandRowSSE2(const unsigned char* src, unsigned char* dst, int width)
+{
+    const __m128i bits = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+    int fullBytes = width >> 3, i = 0;
+    for (; i + 16 <= fullBytes; i += 16)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i bytes2[2] = {_mm_unpacklo_epi8(s, s), _mm_unpackhi_epi8(s, s)};
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i bytes4lo = _mm_unpacklo_epi16(bytes2[h], bytes2[h]),
+                    bytes4hi = _mm_unpackhi_epi16(bytes2[h], bytes2[h]);
+            __m128i bytes8[4] = {_mm_unpacklo_epi32(bytes4lo, bytes4lo), _mm_unpackhi_epi32(bytes4lo, bytes4lo),
+                                 _mm_unpacklo_epi32(bytes4hi, bytes4hi), _mm_unpackhi_epi32(bytes4hi, bytes4hi)};
+            for (int k = 0; k < 4; ++k)
+            {
+                __m128i texels = _mm_cmpeq_epi8(_mm_and_si128(bytes8[k], bits), bits);
+                _mm_storeu_si128((__m128i*)(dst + (i + h * 8 + k * 2) * 8), texels);
+            }
+        }
+    }
+    expandRowTail(src, dst, width, i);
+}
+#endif
+
+#ifdef BIT_EXPAND_HAVE_NEON
+// 2 source bytes to 16 texels: duplicate each byte across a half vector, then test its bits
+static void expandRowNEON(const unsigned char* src, unsigned char* dst, int width)
+{
+    static const uint8_t cBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vld1q_u8(cBits);
+    int fullBytes = width >> 3, i = 0;
+    for (; i + 2 <= fullBytes; i += 2)
+    {
+        uint8x16_t s = vcombine_u8(vdup_n_u8(src[i]), vdup_n_u8(src[i + 1]));
+        vst1q_u8(dst + i * 8, vtstq_u8(s, bits));
+    }
+    expandRowTail(src, dst, width, i);
+}
+#endif
+
+#ifdef BIT_EXPAND_HAVE_SIMD128
+// 2 source bytes to 16 texels: swizzle each byte across a half vector, then test its bits
+static void expandRowSIMD128(const unsigned char* src, unsigned char* dst, int width)
+{
+    const v128_t bits = wasm_u8x16_make(1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128);
+    const v128_t spread = wasm_u8x16_make(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    int fullBytes = width >> 3, i = 0;
+    for (; i + 2 <= fullBytes; i += 2)
+    {
+        v128_t s = wasm_i8x16_swizzle(wasm_v128_load16_splat(src + i), spread);
+        wasm_v128_store(dst + i * 8, wasm_i8x16_eq(wasm_v128_and(s, bits), bits));
+    }
+    expandRowTail(src, dst, width, i);
+}
+#endif
+
+static void expandRowScalar(const unsigned char* src, unsigned char* dst, int width)
+{
+    expandRowTail(src, dst, width, 0);
+}
+
+bool bitExpandBackendAvailable(BitExpandBackend backend)
+{
+    switch (backend)
+    {
+        case BIT_EXPAND_SCALAR: return true;
+        #ifdef BIT_EXPAND_HAVE_SSE2
+        case BIT_EXPAND_SSE2: return true;
+        #endif
+        #ifdef BIT_EXPAND_HAVE_NEON
+        case BIT_EXPAND_NEON: return true;
+        #endif
+        #ifdef BIT_EXPAND_HAVE_SIMD128
+        case BIT_EXPAND_SIMD128: return true;
+        #endif
+        default: return false;
+    }
+}
+
+const char* bitExpandBackendName(BitExpandBackend backend)
+{
+    switch (backend)
+    {
+        case BIT_EXPAND_SCALAR: return "scalar";
+        case BIT_EXPAND_SSE2: return "sse2";
+        case BIT_EXPAND_NEON: return "neon";
+        case BIT_EXPAND_SIMD128: return "simd128";
+        default: return "unknown";
+    }
+}
+
+BitExpandBackend bitExpandBestBackend()
+{
+    for (int backend = BIT_EXPAND_BACKENDS - 1; backend > BIT_EXPAND_SCALAR; --backend)
+        if (bitExpandBackendAvailable((BitExpandBackend)backend))
+            return (BitExpandBackend)backend;
+    return BIT_EXPAND_SCALAR;
+}
+
+void bitExpand(const unsigned char* src, int srcStride, unsigned char* dst, int width, int height, BitExpandBackend backend)
+{
+    void (*expandRow)(const unsigned char*, unsigned char*, int) = expandRowScalar;
+    switch (backend)
+    {
+        #ifdef BIT_EXPAND_HAVE_SSE2
+        case BIT_EXPAND_SSE2: expandRow = expandRowSSE2; break;
+        #endif
+        #ifdef BIT_EXPAND_HAVE_NEON
+        case BIT_EXPAND_NEON: expandRow = expandRowNEON; break;
+        #endif
+        #ifdef BIT_EXPAND_HAVE_SIMD128
+        case BIT_EXPAND_SIMD128: expandRow = expandRowSIMD128; break;
+        #endif
+        default: break;
+    }
+
+    for (int i = 0; i < height; ++i)
+        expandRow(src + i * srcStride, dst + i * width, width);
+}
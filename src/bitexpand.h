@@ -0,0 +1,21 @@
+//
+// Expansion of 1 bit per texel bitmaps to 8 bits per texel, used by texfont for
+// TXF_FORMAT_BITMAP atlases. Bits are LSB first: bit j of byte j / 8 is texel j,
+// set bits become 255 and clear bits 0.
+//
+#pragma once
+
+enum BitExpandBackend {BIT_EXPAND_SCALAR, BIT_EXPAND_SSE2, BIT_EXPAND_NEON, BIT_EXPAND_SIMD128, BIT_EXPAND_BACKENDS};
+
+// Backends are chosen at compile time (-msse2, NEON, -msimd128), scalar is always available
+extern bool bitExpandBackendAvailable(BitExpandBackend backend);
+
+extern const char* bitExpandBackendName(BitExpandBackend backend);
+
+extern BitExpandBackend bitExpandBestBackend();
+
+// Expand width x height texels from src rows of srcStride bytes into dst rows of width bytes
+extern void bitExpand(
+    const unsigned char* src, int srcStride,
+    unsigned char* dst, int width, int height,
+    BitExpandBackend backend = bitExpandBestBackend());
@@ -1,7 +1,7 @@
 :: Requires Emscripten to build: https://kripken.github.io/emscripten-site/docs/getting_started/downloads.html
 :: Successfully built with emsdk 1.38.34
-call emcc -std=c++11 -DEVENTS_DEBUG=1 hello_triangle.cpp events.cpp camera.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 -o ..\hello_triangle.js
-call emcc -std=c++11 hello_texture.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS="[""png""]" -s FULL_ES2=1 -s WASM=0 --preload-file media/texmap.png -o ..\hello_texture.js
-call emcc -std=c++11 hello_text_ttf.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_TTF=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/LiberationSansBold.ttf -o ..\hello_text_ttf.js
-call emcc -std=c++11 hello_text_txf.cpp events.cpp camera.cpp texfont.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o ..\hello_text_txf.js
-call emcc -std=c++11 hello_image.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s FULL_ES2=1 -s WASM=0 -o ../hello_image.js
+call emcc -std=c++11 -DEVENTS_DEBUG=1 hello_triangle.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o ..\hello_triangle.js
+call emcc -std=c++11 hello_texture.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp texstream.cpp ktx.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS="[""png""]" -s FULL_ES2=1 -s WASM=0 -DMEDIA_URL=src/media/ --preload-file media/rockfont.txf -o ..\hello_texture.js
+call emcc -std=c++11 hello_text_ttf.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp ttfatlas.cpp texture.cpp mipmap.cpp -s USE_SDL=2 -s USE_SDL_TTF=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/LiberationSansBold.ttf --preload-file media/rockfont.txf -o ..\hello_text_ttf.js
+call emcc -std=c++11 hello_text_txf.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont_sdf.txf --preload-file media/rockfont.txf -o ..\hello_text_txf.js
+call emcc -std=c++11 hello_image.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp checkerfill.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o ../hello_image.js
@@ -0,0 +1,318 @@
+//
+// CPU fill of checkerboard images with a one pixel border
+//
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#define CHECKER_FILL_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CHECKER_FILL_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(__wasm_simd128__)
+#define CHECKER_FILL_HAVE_SIMD128 1
+#include <wasm_simd128.h>
+#endif
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define CHECKER_FILL_HAVE_THREADS 1
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+#include "checkerfill.h"
+
+// Fewer pixels than this per thread cost more to hand over than to fill
+static const int cMinPixelsPerThread = 64 * 1024;
+
+typedef void (*FillSpanFn)(unsigned int* dst, int count, unsigned int color);
+
+static void fillSpanScalar(unsigned int* dst, int count, unsigned int color)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = color;
+}
+
+#ifdef CHECKER_FILL_HAVE_SSE2
+static void fillSpanSSE2(unsigned int* dst, int count, unsigned int color)
+{
+    const __m128i colors = _mm_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i*)(dst + i), colors);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), colors);
+    }
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)(dst + i), colors);
+    fillSpanScalar(dst + i, count - i, color);
+}
+#endif
+
+#ifdef CHECKER_FILL_HAVE_NEON
+static void fillSpanNEON(unsigned int* dst, int count, unsigned int color)
+{
+    const uint32x4_t colors = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        vst1q_u32(dst + i, colors);
+        vst1q_u32(dst + i + 4, colors);
+    }
+    for (; i + 4 <= count; i += 4)
+        vst1q_u32(dst + i, colors);
+    fillSpanScalar(dst + i, count - i, color);
+}
+#endif
+
+#ifdef CHECKER_FILL_HAVE_SIMD128
+static void fillSpanSIMD128(unsigned int* dst, int count, unsigned int color)
+{
+    const v128_t colors = wasm_i32x4_splat((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        wasm_v128_store(dst + i, colors);
+        wasm_v128_store(dst + i + 4, colors);
+    }
+    for (; i + 4 <= count; i += 4)
+        wasm_v128_store(dst + i, colors);
+    fillSpanScalar(dst + i, count - i, color);
+}
+#endif
+
+static bool isBorderRow(const CheckerImage* image, int y)
+{
+    return y == 0 || y == image->height - 1;
+}
+
+// Light squares start the pattern in either direction
+static bool inFirstHalf(const CheckerImage* image, int i)
+{
+    return i % image->checker_size < image->checker_size / 2;
+}
+
+unsigned int checkerPixel(const CheckerImage* image, int x, int y)
+{
+    if (isBorderRow(image, y) || x == 0 || x == image->width - 1)
+        return image->border;
+    return inFirstHalf(image, x) == inFirstHalf(image, y) ? image->light : image->dark;
+}
+
+// Fill width pixels of image row y from x as runs: the border pixels, then a run
+// per half checker
+static void fillRow(const CheckerImage* image, int x, int y, int width, unsigned int* dst, FillSpanFn fillSpan)
+{
+    if (isBorderRow(image, y))
+    {
+        fillSpan(dst, width, image->border);
+        return;
+    }
+
+    const int checkerSize = image->checker_size, halfChecker = checkerSize / 2;
+    const bool lightFirst = inFirstHalf(image, y);
+    int end = x + width;
+    for (int col = x; col < end;)
+    {
+        int runEnd;
+        unsigned int color;
+        if (col == 0 || col == image->width - 1)
+        {
+            runEnd = col + 1;
+            color = image->border;
+        }
+        else
+        {
+            int mod = col % checkerSize;
+            bool firstHalf = mod < halfChecker;
+            runEnd = col - mod + (firstHalf ? halfChecker : checkerSize);
+            if (runEnd > image->width - 1)
+                runEnd = image->width - 1;
+            color = firstHalf == lightFirst ? image->light : image->dark;
+        }
+        if (runEnd > end)
+            runEnd = end;
+        fillSpan(dst + col - x, runEnd - col, color);
+        col = runEnd;
+    }
+}
+
+// Fill region rows [firstRow, endRow), copying rows that repeat the row above
+static void fillRows(const CheckerImage* image, int x, int y, int width, int firstRow, int endRow,
+                     unsigned int* dst, FillSpanFn fillSpan)
+{
+    for (int row = firstRow; row < endRow; ++row)
+    {
+        int imageY = y + row;
+        unsigned int* dstRow = dst + row * width;
+        if (row > firstRow && !isBorderRow(image, imageY) && !isBorderRow(image, imageY - 1)
+            && inFirstHalf(image, imageY) == inFirstHalf(image, imageY - 1))
+            memcpy(dstRow, dstRow - width, width * sizeof(unsigned int));
+        else
+            fillRow(image, x, imageY, width, dstRow, fillSpan);
+    }
+}
+
+#ifdef CHECKER_FILL_HAVE_THREADS
+// Workers started as needed and kept for later fills. One fill at a time.
+class CheckerFillPool
+{
+public:
+    ~CheckerFillPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQuit = true;
+        }
+        mWake.notify_all();
+        for (size_t i = 0; i < mWorkers.size(); ++i)
+            mWorkers[i].join();
+    }
+
+    // Run job(0) ... job(tasks - 1), job(0) on the calling thread
+    void run(int tasks, const std::function<void(int)>& job)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while ((int)mWorkers.size() < tasks - 1)
+            mWorkers.push_back(std::thread(&CheckerFillPool::work, this, (int)mWorkers.size() + 1, mGeneration));
+        mJob = &job;
+        mTasks = tasks;
+        mPending = tasks - 1;
+        ++mGeneration;
+        lock.unlock();
+        mWake.notify_all();
+
+        job(0);
+
+        lock.lock();
+        mFinished.wait(lock, [this]() { return mPending == 0; });
+        mJob = NULL;
+    }
+
+private:
+    void work(int task, int generation)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (;;)
+        {
+            mWake.wait(lock, [&]() { return mQuit || mGeneration != generation; });
+            if (mQuit)
+                return;
+            generation = mGeneration;
+            if (task < mTasks)
+            {
+                const std::function<void(int)>* job = mJob;
+                lock.unlock();
+                (*job)(task);
+                lock.lock();
+                if (--mPending == 0)
+                    mFinished.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mFinished;
+    const std::function<void(int)>* mJob = NULL;
+    int mTasks = 0;
+    int mPending = 0;
+    int mGeneration = 0;
+    bool mQuit = false;
+};
+#endif
+
+bool checkerFillBackendAvailable(CheckerFillBackend backend)
+{
+    switch (backend)
+    {
+        case CHECKER_FILL_SCALAR: return true;
+        #ifdef CHECKER_FILL_HAVE_SSE2
+        case CHECKER_FILL_SSE2: return true;
+        #endif
+        #ifdef CHECKER_FILL_HAVE_NEON
+        case CHECKER_FILL_NEON: return true;
+        #endif
+        #ifdef CHECKER_FILL_HAVE_SIMD128
+        case CHECKER_FILL_SIMD128: return true;
+        #endif
+        default: return false;
+    }
+}
+
+const char* checkerFillBackendName(CheckerFillBackend backend)
+{
+    switch (backend)
+    {
+        case CHECKER_FILL_SCALAR: return "scalar";
+        case CHECKER_FILL_SSE2: return "sse2";
+        case CHECKER_FILL_NEON: return "neon";
+        case CHECKER_FILL_SIMD128: return "simd128";
+        default: return "unknown";
+    }
+}
+
+CheckerFillBackend checkerFillBestBackend()
+{
+    for (int backend = CHECKER_FILL_BACKENDS - 1; backend > CHECKER_FILL_SCALAR; --backend)
+        if (checkerFillBackendAvailable((CheckerFillBackend)backend))
+            return (CheckerFillBackend)backend;
+    return CHECKER_FILL_SCALAR;
+}
+
+int checkerFillMaxThreads()
+{
+#ifdef CHECKER_FILL_HAVE_THREADS
+    int threads = (int)std::thread::hardware_concurrency();
+    return threads < 1 ? 1 : (threads > 8 ? 8 : threads);
+#else
+    return 1;
+#endif
+}
+
+void checkerFill(const CheckerImage* image, int x, int y, int width, int height, unsigned int* dst,
+                 CheckerFillBackend backend, int threads)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    FillSpanFn fillSpan = fillSpanScalar;
+    switch (backend)
+    {
+        #ifdef CHECKER_FILL_HAVE_SSE2
+        case CHECKER_FILL_SSE2: fillSpan = fillSpanSSE2; break;
+        #endif
+        #ifdef CHECKER_FILL_HAVE_NEON
+        case CHECKER_FILL_NEON: fillSpan = fillSpanNEON; break;
+        #endif
+        #ifdef CHECKER_FILL_HAVE_SIMD128
+        case CHECKER_FILL_SIMD128: fillSpan = fillSpanSIMD128; break;
+        #endif
+        default: break;
+    }
+
+    // Split the rows evenly, every thread with enough pixels to be worth waking
+    int maxThreads = (int)((long long)width * height / cMinPixelsPerThread);
+    if (threads > maxThreads)
+        threads = maxThreads;
+    if (threads > height)
+        threads = height;
+
+#ifdef CHECKER_FILL_HAVE_THREADS
+    if (threads > 1)
+    {
+        static CheckerFillPool pool;
+        pool.run(threads, [&](int task) {
+            int firstRow = (int)((long long)height * task / threads);
+            int endRow = (int)((long long)height * (task + 1) / threads);
+            fillRows(image, x, y, width, firstRow, endRow, dst, fillSpan);
+        });
+        return;
+    }
+#endif
+    fillRows(image, x, y, width, 0, height, dst, fillSpan);
+}
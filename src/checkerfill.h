@@ -0,0 +1,43 @@
+//
+// CPU fill of checkerboard images with a one pixel border, used by hello_image for its
+// background texture. Rows are filled as runs of constant color with wide stores, rows
+// repeating the row above are copied, and large regions are split across threads.
+//
+#pragma once
+
+enum CheckerFillBackend {CHECKER_FILL_SCALAR, CHECKER_FILL_SSE2, CHECKER_FILL_NEON, CHECKER_FILL_SIMD128, CHECKER_FILL_BACKENDS};
+
+typedef struct {
+    int width;                  // Whole image, the border is its outermost pixels
+    int height;
+    int checker_size;           // Pixels per light + dark square pair, light squares at 0,0
+    unsigned int border;        // Pixels, as stored
+    unsigned int light;
+    unsigned int dark;
+} CheckerImage;
+
+// Backends are chosen at compile time (-msse2, NEON, -msimd128), scalar is always available
+extern bool checkerFillBackendAvailable(CheckerFillBackend backend);
+
+extern const char* checkerFillBackendName(CheckerFillBackend backend);
+
+extern CheckerFillBackend checkerFillBestBackend();
+
+// Threads a fill may use: the hardware threads, up to 8. 1 on Emscripten builds
+// without -pthread.
+extern int checkerFillMaxThreads();
+
+// Pixel x,y of image, the reference for checkerFill
+extern unsigned int checkerPixel(
+    const CheckerImage* image,
+    int x, int y);
+
+// Fill dst with the width x height region at x,y of image, rows tightly packed.
+// Regions too small to be worth it are filled on the calling thread only.
+extern void checkerFill(
+    const CheckerImage* image,
+    int x, int y,
+    int width, int height,
+    unsigned int* dst,
+    CheckerFillBackend backend = checkerFillBestBackend(),
+    int threads = checkerFillMaxThreads());
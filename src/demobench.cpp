@@ -0,0 +1,93 @@
+//
+// Headless benchmark of the samples' main loops, native only
+//
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include <SDL.h>
+#include <SDL_opengles2.h>
+#include "demobench.h"
+#include "events.h"
+#include "glstate.h"
+#include "profile.h"
+
+static const int cDefaultFrames = 600;
+
+// Frames per cycle of the camera's zoom and pan
+static const int cCameraPeriod = 120;
+
+int demoBenchFrames(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bench") != 0)
+            continue;
+        int frames = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+        return frames > 0 ? frames : cDefaultFrames;
+    }
+    return 0;
+}
+
+// Peak resident set size of the process in KB, -1 if not known
+static long peakResidentKB()
+{
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef __APPLE__
+    return (long)(usage.ru_maxrss / 1024);     // Bytes on macOS
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+void demoBenchRun(const char* name, EventHandler& eventHandler, void (*mainLoop)(void*), int frames)
+{
+    if (!profileEnabled())
+        profileStart(NULL, NULL);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    printf("INFO: Benchmarking %s, %d frames%s on %s\n", name, frames,
+           eventHandler.replaying() ? " at most, input replayed" : "", renderer ? renderer : "unknown renderer");
+
+    // Every frame is drawn, the camera changing as if zoomed and panned, so each frame
+    // updates the shaders too. Replayed input moves the camera instead, until it ends.
+    Camera& camera = eventHandler.camera();
+    bool replay = eventHandler.replaying();
+    GLStateCounters start = glStateTotals();
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    int drawn = 0;
+    for (; drawn < frames && (!replay || eventHandler.replaying()); ++drawn)
+    {
+        if (!replay)
+        {
+            float angle = drawn * 2.0f * (float)M_PI / cCameraPeriod;
+            camera.setZoom(1.0f + 0.5f * sinf(angle));
+            Vec2 pan = {0.25f * cosf(angle), 0.25f * sinf(angle)};
+            camera.setPan(pan);
+        }
+        eventHandler.requestRedraw();
+        mainLoop(&eventHandler);
+    }
+    double seconds = (SDL_GetPerformanceCounter() - startTime) / (double)SDL_GetPerformanceFrequency();
+    GLStateCounters end = glStateTotals();
+
+    // One line per run, key=value, for scripts comparing runs. Percentiles are of the last
+    // PROFILE_HISTORY frames, so longer runs leave out the first frames' uploads and warm up.
+    ProfileStats frame = profileStats(PROFILE_FRAME);
+    ProfileStats redraw = profileStats(PROFILE_REDRAW);
+    ProfileStats gpu = profileStats(PROFILE_GPU);
+    printf("BENCH: %s frames=%d seconds=%.3f frame_p50_ms=%.3f frame_p95_ms=%.3f frame_p99_ms=%.3f "
+           "redraw_p50_ms=%.3f redraw_p99_ms=%.3f gpu_p50_ms=%.3f gl_issued_per_frame=%.1f "
+           "gl_filtered_per_frame=%.1f peak_rss_kb=%ld\n",
+           name, drawn, seconds, frame.p50_ms, frame.p95_ms, frame.p99_ms, redraw.p50_ms, redraw.p99_ms,
+           gpu.samples ? gpu.p50_ms : -1.0f, (end.issued - start.issued) / (double)(drawn > 0 ? drawn : 1),
+           (end.filtered - start.filtered) / (double)(drawn > 0 ? drawn : 1), peakResidentKB());
+}
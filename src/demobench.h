@@ -0,0 +1,28 @@
+//
+// Headless benchmark of the samples' main loops. A sample run natively with --bench <frames>
+// draws that many frames back to back, zooming and panning the camera every frame, prints
+// its frame times, GL state calls and peak memory, and returns from main. Under SDL's
+// offscreen video driver and Mesa's software rasterizer no display or GPU is needed:
+//
+//     SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./hello_triangle --bench 600
+//
+// The bench target of CMakeLists.txt runs every sample this way.
+//
+#pragma once
+
+class EventHandler;
+
+// Frames to draw, from --bench [frames] in argv, 0 if not benchmarking
+extern int demoBenchFrames(
+    int argc,
+    char** argv);
+
+// Call mainLoop(&eventHandler) frames times, moving the camera before each, or while
+// replayed input remains (see EventHandler::replayEvents) and moves it, then print
+// one line of results for name: frame, redraw and GPU time percentiles (see profile.h),
+// GL state calls per frame (see glstate.h) and the process's peak resident memory
+extern void demoBenchRun(
+    const char* name,
+    EventHandler& eventHandler,
+    void (*mainLoop)(void*),
+    int frames);
@@ -0,0 +1,300 @@
+//
+// Input event logs, recorded and replayed by EventHandler
+//
+#include <string.h>
+#include "eventlog.h"
+
+static const char cMagic[8] = {'S', 'D', 'L', 'E', 'V', 'L', 'G', '1'};
+
+// Frame, time and type before each event's fields
+static const int cRecordHeaderSize = 12;
+static const int cMaxPayloadSize = 36;
+
+// Bytes of the fields recorded for type, 0 if events of type are not recorded
+static int payloadSize(Uint32 type)
+{
+    switch (type)
+    {
+        case SDL_WINDOWEVENT: return 12;
+        case SDL_MOUSEWHEEL: return 20;
+        case SDL_MOUSEMOTION: return 20;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP: return 16;
+        case SDL_FINGERMOTION:
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP: return 36;
+        case SDL_MULTIGESTURE: return 28;
+        default: return 0;
+    }
+}
+
+static void putU32(unsigned char*& p, Uint32 value)
+{
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+    p += 4;
+}
+
+static void putI64(unsigned char*& p, Sint64 value)
+{
+    putU32(p, (Uint32)((Uint64)value & 0xffffffffu));
+    putU32(p, (Uint32)((Uint64)value >> 32));
+}
+
+static void putF32(unsigned char*& p, float value)
+{
+    Uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(p, bits);
+}
+
+static Uint32 getU32(const unsigned char*& p)
+{
+    Uint32 value = p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+    p += 4;
+    return value;
+}
+
+static Sint64 getI64(const unsigned char*& p)
+{
+    Uint64 low = getU32(p);
+    Uint64 high = getU32(p);
+    return (Sint64)(low | (high << 32));
+}
+
+static float getF32(const unsigned char*& p)
+{
+    Uint32 bits = getU32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+EventLog* eventLogCreate(const char* filename, int width, int height)
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+    {
+        printf("ERROR: Failed to create event log %s\n", filename);
+        return NULL;
+    }
+    unsigned char header[8], *p = header;
+    putU32(p, (Uint32)width);
+    putU32(p, (Uint32)height);
+    fwrite(cMagic, 1, sizeof(cMagic), file);
+    fwrite(header, 1, sizeof(header), file);
+
+    EventLog* log = new EventLog();
+    log->file = file;
+    log->writing = true;
+    log->width = width;
+    log->height = height;
+    log->start_ticks = SDL_GetTicks();
+    printf("INFO: Recording events to %s\n", filename);
+    return log;
+}
+
+// Read the next event ahead into log->next, has_next false at the end of the log
+static void readAhead(EventLog* log)
+{
+    log->has_next = false;
+    unsigned char record[cRecordHeaderSize + cMaxPayloadSize];
+    if (fread(record, 1, cRecordHeaderSize, log->file) != (size_t)cRecordHeaderSize)
+        return;
+    const unsigned char* p = record;
+    Uint32 frame = getU32(p);
+    Uint32 ms = getU32(p);
+    Uint32 type = getU32(p);
+    int size = payloadSize(type);
+    if (size == 0 || fread(record + cRecordHeaderSize, 1, size, log->file) != (size_t)size)
+    {
+        printf("ERROR: Event log truncated or corrupt after %d events\n", log->events);
+        return;
+    }
+
+    SDL_Event& event = log->next;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.common.timestamp = log->start_ticks + ms;
+    switch (type)
+    {
+        case SDL_WINDOWEVENT:
+            event.window.event = (Uint8)getU32(p);
+            event.window.data1 = (Sint32)getU32(p);
+            event.window.data2 = (Sint32)getU32(p);
+            break;
+        case SDL_MOUSEWHEEL:
+            event.wheel.x = (Sint32)getU32(p);
+            event.wheel.y = (Sint32)getU32(p);
+            event.wheel.preciseX = getF32(p);
+            event.wheel.preciseY = getF32(p);
+            event.wheel.direction = getU32(p);
+            break;
+        case SDL_MOUSEMOTION:
+            event.motion.x = (Sint32)getU32(p);
+            event.motion.y = (Sint32)getU32(p);
+            event.motion.xrel = (Sint32)getU32(p);
+            event.motion.yrel = (Sint32)getU32(p);
+            event.motion.state = getU32(p);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            event.button.button = (Uint8)getU32(p);
+            event.button.clicks = (Uint8)getU32(p);
+            event.button.state = type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+            event.button.x = (Sint32)getU32(p);
+            event.button.y = (Sint32)getU32(p);
+            break;
+        case SDL_FINGERMOTION:
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+            event.tfinger.touchId = getI64(p);
+            event.tfinger.fingerId = getI64(p);
+            event.tfinger.x = getF32(p);
+            event.tfinger.y = getF32(p);
+            event.tfinger.dx = getF32(p);
+            event.tfinger.dy = getF32(p);
+            event.tfinger.pressure = getF32(p);
+            break;
+        case SDL_MULTIGESTURE:
+            event.mgesture.touchId = getI64(p);
+            event.mgesture.dTheta = getF32(p);
+            event.mgesture.dDist = getF32(p);
+            event.mgesture.x = getF32(p);
+            event.mgesture.y = getF32(p);
+            event.mgesture.numFingers = (Uint16)getU32(p);
+            break;
+    }
+    log->next_frame = frame;
+    log->has_next = true;
+}
+
+EventLog* eventLogOpen(const char* filename)
+{
+    FILE* file = fopen(filename, "rb");
+    char magic[sizeof(cMagic)];
+    unsigned char header[8];
+    if (!file || fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, cMagic, sizeof(magic)) != 0
+        || fread(header, 1, sizeof(header), file) != sizeof(header))
+    {
+        printf("ERROR: Failed to open event log %s\n", filename);
+        if (file)
+            fclose(file);
+        return NULL;
+    }
+
+    const unsigned char* p = header;
+    EventLog* log = new EventLog();
+    log->file = file;
+    log->writing = false;
+    log->width = (int)getU32(p);
+    log->height = (int)getU32(p);
+    log->start_ticks = SDL_GetTicks();
+    readAhead(log);
+    printf("INFO: Replaying events from %s, recorded in a %dx%d window\n", filename, log->width, log->height);
+    return log;
+}
+
+void eventLogWrite(EventLog* log, Uint32 frame, const SDL_Event* event)
+{
+    int size = payloadSize(event->type);
+    if (size == 0)
+        return;
+
+    unsigned char record[cRecordHeaderSize + cMaxPayloadSize], *p = record;
+    putU32(p, frame);
+    putU32(p, SDL_GetTicks() - log->start_ticks);
+    putU32(p, event->type);
+    switch (event->type)
+    {
+        case SDL_WINDOWEVENT:
+            putU32(p, event->window.event);
+            putU32(p, (Uint32)event->window.data1);
+            putU32(p, (Uint32)event->window.data2);
+            break;
+        case SDL_MOUSEWHEEL:
+            putU32(p, (Uint32)event->wheel.x);
+            putU32(p, (Uint32)event->wheel.y);
+            putF32(p, event->wheel.preciseX);
+            putF32(p, event->wheel.preciseY);
+            putU32(p, event->wheel.direction);
+            break;
+        case SDL_MOUSEMOTION:
+            putU32(p, (Uint32)event->motion.x);
+            putU32(p, (Uint32)event->motion.y);
+            putU32(p, (Uint32)event->motion.xrel);
+            putU32(p, (Uint32)event->motion.yrel);
+            putU32(p, event->motion.state);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            putU32(p, event->button.button);
+            putU32(p, event->button.clicks);
+            putU32(p, (Uint32)event->button.x);
+            putU32(p, (Uint32)event->button.y);
+            break;
+        case SDL_FINGERMOTION:
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+            putI64(p, event->tfinger.touchId);
+            putI64(p, event->tfinger.fingerId);
+            putF32(p, event->tfinger.x);
+            putF32(p, event->tfinger.y);
+            putF32(p, event->tfinger.dx);
+            putF32(p, event->tfinger.dy);
+            putF32(p, event->tfinger.pressure);
+            break;
+        case SDL_MULTIGESTURE:
+            putI64(p, event->mgesture.touchId);
+            putF32(p, event->mgesture.dTheta);
+            putF32(p, event->mgesture.dDist);
+            putF32(p, event->mgesture.x);
+            putF32(p, event->mgesture.y);
+            putU32(p, event->mgesture.numFingers);
+            break;
+    }
+    fwrite(record, 1, cRecordHeaderSize + size, log->file);
+    ++log->events;
+}
+
+bool eventLogRead(EventLog* log, Uint32 frame, Uint32 windowID, SDL_Event* event)
+{
+    // Events of frames already past are late, not lost
+    if (!log->has_next || log->next_frame > frame)
+        return false;
+    *event = log->next;
+    switch (event->type)
+    {
+        case SDL_WINDOWEVENT: event->window.windowID = windowID; break;
+        case SDL_MOUSEWHEEL: event->wheel.windowID = windowID; break;
+        case SDL_MOUSEMOTION: event->motion.windowID = windowID; break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP: event->button.windowID = windowID; break;
+    }
+    ++log->events;
+    readAhead(log);
+    return true;
+}
+
+bool eventLogFinished(const EventLog* log)
+{
+    return !log->writing && !log->has_next;
+}
+
+void eventLogClose(EventLog* log)
+{
+    if (!log)
+        return;
+    if (log->writing)
+    {
+        if (fclose(log->file) != 0)
+            printf("ERROR: Failed to write event log\n");
+        else
+            printf("INFO: Recorded %d events\n", log->events);
+    }
+    else
+        fclose(log->file);
+    delete log;
+}
@@ -0,0 +1,55 @@
+//
+// Input event logs: the SDL events EventHandler handles, each with the frame it was
+// processed in and its time since recording started, in a compact binary file. Replayed
+// frame by frame, the same events reach the same frames whatever the frame rate, so a
+// recorded pan, zoom or pinch session redraws the same way on every run.
+//
+// File: "SDLEVLG1", window width and height (uint32), then per event its frame, time in
+// ms and SDL event type (uint32), then the fields EventHandler reads for that type.
+// Little endian throughout.
+//
+#pragma once
+#include <stdio.h>
+#include <SDL.h>
+
+typedef struct {
+    FILE* file;
+    bool writing;
+    int width, height;          // Window size when recorded
+    Uint32 start_ticks;         // SDL_GetTicks when recording or replay started
+    int events;                 // Events written or read so far
+    bool has_next;              // Reading: next holds the event read ahead
+    Uint32 next_frame;
+    SDL_Event next;
+} EventLog;
+
+// Create filename and record to it, the window width x height. Returns NULL on failure.
+extern EventLog* eventLogCreate(
+    const char* filename,
+    int width, int height);
+
+// Open a log written by eventLogCreate to replay. Returns NULL on failure.
+extern EventLog* eventLogOpen(
+    const char* filename);
+
+// Record event as processed in frame. Events EventHandler ignores are not recorded.
+extern void eventLogWrite(
+    EventLog* log,
+    Uint32 frame,
+    const SDL_Event* event);
+
+// The next event recorded in frame, false once there are none. Window events are
+// given windowID.
+extern bool eventLogRead(
+    EventLog* log,
+    Uint32 frame,
+    Uint32 windowID,
+    SDL_Event* event);
+
+// Whether every recorded event has been read
+extern bool eventLogFinished(
+    const EventLog* log);
+
+// Close the file, written out if recording, and free log. log may be NULL.
+extern void eventLogClose(
+    EventLog* log);
@@ -1,21 +1,47 @@
 //
 // Window and input event handling
 //
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
 #include <algorithm>
+#include <stdio.h>
 #include <SDL.h>
 #include <SDL_opengles2.h>
 #include "events.h"
 
 // #define EVENTS_DEBUG
 
+// Longest wait for events between idle frames, natively, and how often frames and CPU
+// use are printed when redrawing on demand
+const Uint32 cIdleWaitMs = 250;
+const Uint32 cStatsIntervalMs = 10000;
+
+// Natively the window opens at this size, under Emscripten the canvas sizes it
+const int cNativeWindowWidth = 640, cNativeWindowHeight = 480;
+
 void EventHandler::windowResizeEvent(int width, int height)
 {
-    glViewport(0, 0, width, height);
+    // Dragging a window edge sends bursts of resize events, the viewport
+    // is set once they have all been processed
     mCamera.setWindowSize(width, height);
+    mViewportChanged = true;
+    mRedrawRequested = true;
+}
+
+void EventHandler::updateViewport()
+{
+    glViewport(0, 0, mCamera.windowSize().width, mCamera.windowSize().height);
+    mViewportChanged = false;
 }
 
 void EventHandler::initWindow(const char* title)
 {
+#ifndef __EMSCRIPTEN__
+    mCamera.setWindowSize(cNativeWindowWidth, cNativeWindowHeight);
+#endif
+
     // Create SDL window
     mpWindow = 
         SDL_CreateWindow(title, 
@@ -28,6 +54,7 @@ void EventHandler::initWindow(const char* title)
     // Create OpenGLES 2 context on SDL window
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
     SDL_GL_SetSwapInterval(1);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
@@ -38,6 +65,13 @@ void EventHandler::initWindow(const char* title)
 
     // Initialize viewport
     windowResizeEvent(mCamera.windowSize().width, mCamera.windowSize().height);
+    updateViewport();
+}
+
+EventHandler::~EventHandler()
+{
+    eventLogClose(mpRecordLog);
+    eventLogClose(mpReplayLog);
 }
 
 void EventHandler::swapWindow()
@@ -45,6 +79,149 @@ void EventHandler::swapWindow()
     SDL_GL_SwapWindow(mpWindow);
 }
 
+void EventHandler::setRedrawOnDemand(bool onDemand)
+{
+#ifdef __EMSCRIPTEN__
+    if (onDemand && !mRedrawOnDemand)
+        SDL_AddEventWatch(resumeOnEvent, this);
+    else if (!onDemand && mRedrawOnDemand)
+        SDL_DelEventWatch(resumeOnEvent, this);
+#endif
+    mRedrawOnDemand = onDemand;
+    mStatsStartTicks = 0;
+    mFramesDrawn = mFramesSkipped = 0;
+    requestRedraw();
+}
+
+void EventHandler::requestRedraw()
+{
+    mRedrawRequested = true;
+#ifdef __EMSCRIPTEN__
+    if (mMainLoopPaused)
+    {
+        mMainLoopPaused = false;
+        emscripten_resume_main_loop();
+    }
+#endif
+}
+
+// Called as each event is queued, from the browser's event handlers while the main
+// loop is paused
+int SDLCALL EventHandler::resumeOnEvent(void* userdata, SDL_Event* event)
+{
+#ifdef __EMSCRIPTEN__
+    EventHandler* handler = (EventHandler*)userdata;
+    if (handler->mMainLoopPaused)
+    {
+        handler->mMainLoopPaused = false;
+        emscripten_resume_main_loop();
+    }
+#endif
+    return 0;
+}
+
+bool EventHandler::redrawNeeded()
+{
+    bool needed = !mRedrawOnDemand || mRedrawRequested;
+    mRedrawRequested = false;
+    if (!mRedrawOnDemand)
+        return true;
+
+    if (needed)
+        ++mFramesDrawn;
+    else
+    {
+        // Nothing to draw until an event arrives. The frame's events were processed,
+        // so the next one queued is new.
+        ++mFramesSkipped;
+        if (!mpReplayLog)
+        {
+#ifdef __EMSCRIPTEN__
+            mMainLoopPaused = true;
+            emscripten_pause_main_loop();
+#else
+            SDL_WaitEventTimeout(NULL, cIdleWaitMs);
+#endif
+        }
+    }
+
+    printStats();
+    return needed;
+}
+
+void EventHandler::printStats()
+{
+#ifndef __EMSCRIPTEN__
+    Uint32 ticks = SDL_GetTicks();
+    clock_t cpu = clock();
+    if (mStatsStartTicks == 0)
+    {
+        mStatsStartTicks = ticks;
+        mStatsStartClock = cpu;
+    }
+    else if (ticks - mStatsStartTicks >= cStatsIntervalMs)
+    {
+        // Process CPU time, every thread's, over wall time
+        double seconds = (ticks - mStatsStartTicks) / 1000.0;
+        double cpuSeconds = (cpu - mStatsStartClock) / (double)CLOCKS_PER_SEC;
+        printf("INFO: %d frames drawn, %d idle in %.1f s, CPU %.1f%%\n",
+               mFramesDrawn, mFramesSkipped, seconds, 100.0 * cpuSeconds / seconds);
+        mStatsStartTicks = ticks;
+        mStatsStartClock = cpu;
+        mFramesDrawn = mFramesSkipped = 0;
+    }
+#endif
+}
+
+bool EventHandler::recordEvents(const char* filename)
+{
+    eventLogClose(mpRecordLog);
+    mpRecordLog = eventLogCreate(filename, mCamera.windowSize().width, mCamera.windowSize().height);
+    mFrame = 0;
+    return mpRecordLog != nullptr;
+}
+
+bool EventHandler::replayEvents(const char* filename)
+{
+    eventLogClose(mpReplayLog);
+    mpReplayLog = eventLogOpen(filename);
+    if (!mpReplayLog)
+        return false;
+
+    // Positions map to the view as they did in the window recorded
+    if (mpReplayLog->width > 0 && mpReplayLog->height > 0)
+    {
+        SDL_SetWindowSize(mpWindow, mpReplayLog->width, mpReplayLog->height);
+        windowResizeEvent(mpReplayLog->width, mpReplayLog->height);
+    }
+    mFrame = 0;
+    return true;
+}
+
+// The next event to process this frame, recorded if recording. While replaying, the
+// log's events take the place of the window's, but for quitting.
+bool EventHandler::pollEvent(SDL_Event* event)
+{
+    bool polled = false;
+    while (!polled && SDL_PollEvent(event))
+        polled = !mpReplayLog || event->type == SDL_QUIT;
+
+    if (!polled && mpReplayLog)
+    {
+        polled = eventLogRead(mpReplayLog, mFrame, mWindowID, event);
+        if (!polled && eventLogFinished(mpReplayLog))
+        {
+            printf("INFO: Replay finished, %d events in %u frames\n", mpReplayLog->events, mFrame + 1);
+            eventLogClose(mpReplayLog);
+            mpReplayLog = nullptr;
+        }
+    }
+
+    if (polled && mpRecordLog)
+        eventLogWrite(mpRecordLog, mFrame, event);
+    return polled;
+}
+
 void EventHandler::zoomEventMouse(bool mouseWheelDown, int x, int y)
 {                
     float preZoomWorldX, preZoomWorldY;
@@ -53,6 +230,7 @@ void EventHandler::zoomEventMouse(bool mouseWheelDown, int x, int y)
     // Zoom by scaling up/down in 0.05 increments 
     float zoomDelta = mouseWheelDown ? -cMouseWheelZoomDelta : cMouseWheelZoomDelta;
     mCamera.setZoomDelta(zoomDelta);
+    mRedrawRequested = true;
 
     // Zoom to point: Keep the world coords under mouse position the same before and after the zoom
     float postZoomWorldX, postZoomWorldY;
@@ -69,6 +247,7 @@ void EventHandler::zoomEventPinch (float pinchDist, float pinchX, float pinchY)
     // Zoom in/out by positive/negative mPinch distance
     float zoomDelta = pinchDist * cPinchScale;
     mCamera.setZoomDelta(zoomDelta);
+    mRedrawRequested = true;
 
     // Zoom to point: Keep the world coords under pinch position the same before and after the zoom
     float postZoomWorldX, postZoomWorldY;
@@ -88,6 +267,7 @@ void EventHandler::panEventMouse(int x, int y)
     Vec2 pan = { mCamera.basePan().x + deviceX / mCamera.zoom(), 
                  mCamera.basePan().y + deviceY / mCamera.zoom() / mCamera.aspect() };
     mCamera.setPan(pan);
+    mRedrawRequested = true;
 }
 
 void EventHandler::panEventFinger(float x, float y)
@@ -101,17 +281,21 @@ void EventHandler::panEventFinger(float x, float y)
     Vec2 pan = { mCamera.basePan().x + deviceX / mCamera.zoom(), 
                  mCamera.basePan().y + deviceY / mCamera.zoom() / mCamera.aspect() };
     mCamera.setPan(pan);
+    mRedrawRequested = true;
 }
 
 void EventHandler::processEvents()
 {
     // Handle events
     SDL_Event event;
-    while (SDL_PollEvent(&event))
+    while (pollEvent(&event))
     {
         switch (event.type)
         {
             case SDL_QUIT:
+                // Write the recording out first
+                eventLogClose(mpRecordLog);
+                mpRecordLog = nullptr;
                 std::terminate();
                 break;
 
@@ -123,6 +307,9 @@ void EventHandler::processEvents()
                     int width = event.window.data1, height = event.window.data2;
                     windowResizeEvent(width, height);
                 }
+                else if (event.window.windowID == mWindowID
+                         && event.window.event == SDL_WINDOWEVENT_EXPOSED)
+                    mRedrawRequested = true; // Window contents lost, redraw on demand
                 break;
             }
 
@@ -225,4 +412,10 @@ void EventHandler::processEvents()
             printf ("    zoom=%f pan=%f,%f\n", mCamera.zoom(), mCamera.pan()[0], mCamera.pan()[1]);
         #endif
     }
+
+    // Resized: once per frame, however many resize events arrived
+    if (mViewportChanged)
+        updateViewport();
+
+    ++mFrame;
 }
\ No newline at end of file
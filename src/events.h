@@ -1,12 +1,15 @@
 //
 // Window and input event handling
 //
+#include <time.h>
 #include "camera.h"
+#include "eventlog.h"
 
 class EventHandler
 {
 public:
     EventHandler(const char *windowTitle);
+    ~EventHandler();
 
     void processEvents();
 
@@ -14,6 +17,29 @@ public:
 
     void swapWindow();
 
+    // On demand redraw: frames are drawn when the camera, the window or the content
+    // changed, rather than every frame. Idle frames wait for events natively, and pause
+    // the Emscripten main loop until one arrives.
+    void setRedrawOnDemand(bool onDemand);
+
+    // The content changed, draw the next frame
+    void requestRedraw();
+
+    // Call once per frame: whether to draw it, always unless redrawing on demand.
+    // Natively, when redrawing on demand, also prints the frames drawn and idle and the
+    // CPU used every few seconds.
+    bool redrawNeeded();
+
+    // Input recording and replay (see eventlog.h). Recording logs the events processed
+    // to filename. Replaying processes the events read from it, each in the frame it was
+    // recorded in, in place of the window's until they run out. Both count frames from
+    // the call. Return false if the file cannot be opened.
+    bool recordEvents(const char *filename);
+    bool replayEvents(const char *filename);
+
+    // Whether replayed events remain
+    bool replaying() { return mpReplayLog != nullptr; }
+
 private:
     // Camera
     Camera mCamera;
@@ -23,10 +49,31 @@ private:
 
     Uint32 mWindowID;
 
+    bool mViewportChanged;
+
     void windowResizeEvent(int width, int height);
+    void updateViewport();
 
     void initWindow(const char *title);
 
+    // On demand redraw
+    bool mRedrawOnDemand;
+    bool mRedrawRequested;
+    bool mMainLoopPaused;
+    static int SDLCALL resumeOnEvent(void *userdata, SDL_Event *event);
+
+    // Input recording and replay
+    EventLog *mpRecordLog;
+    EventLog *mpReplayLog;
+    Uint32 mFrame;
+    bool pollEvent(SDL_Event *event);
+
+    // Frames and CPU time since the last print, counted when redrawing on demand
+    Uint32 mStatsStartTicks;
+    clock_t mStatsStartClock;
+    int mFramesDrawn, mFramesSkipped;
+    void printStats();
+
     // Mouse input
     const float cMouseWheelZoomDelta;
     bool mMouseButtonDown;
@@ -50,7 +97,10 @@ private:
 };
 
 inline EventHandler::EventHandler(const char *windowTitle)
-    : mpWindow(nullptr), mWindowID(0), // Window
+    : mpWindow(nullptr), mWindowID(0), mViewportChanged(false), // Window
+      mRedrawOnDemand(false), mRedrawRequested(true), mMainLoopPaused(false), // Redraw
+      mpRecordLog(nullptr), mpReplayLog(nullptr), mFrame(0), // Recording and replay
+      mStatsStartTicks(0), mStatsStartClock(0), mFramesDrawn(0), mFramesSkipped(0),
       cMouseWheelZoomDelta(0.05f),     // mouse
       mMouseButtonDown(false),
       mMouseButtonDownX(0),
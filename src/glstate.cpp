@@ -0,0 +1,332 @@
+//
+// GL state tracking shared by the samples
+//
+#include <stdio.h>
+#include "glstate.h"
+
+// #define GLSTATE_DEBUG
+
+// Tracked texture units and vertex attributes, the OpenGL ES 2 minimums
+#define GL_STATE_MAX_TEXTURE_UNITS 8
+#define GL_STATE_MAX_ATTRIBS 8
+
+// Never a GL name or enum, so never equal to what a call sets
+static const GLuint cUnknown = 0xffffffffu;
+
+// Capabilities tracked by glStateEnable / glStateDisable
+static const GLenum cCaps[] = {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST, GL_STENCIL_TEST};
+static const int cCapCount = sizeof(cCaps) / sizeof(cCaps[0]);
+
+typedef struct {
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+    const void* pointer;
+    GLuint buffer;              // GL_ARRAY_BUFFER binding when set, cUnknown if not known
+} AttribPointer;
+
+typedef struct {
+    GLuint program;
+    GLuint array_buffer;
+    GLuint element_array_buffer;
+    GLenum active_texture;
+    GLuint texture_2d[GL_STATE_MAX_TEXTURE_UNITS];
+    GLuint texture_cube_map[GL_STATE_MAX_TEXTURE_UNITS];
+    GLuint attrib_enabled[GL_STATE_MAX_ATTRIBS];    // GL_TRUE, GL_FALSE or cUnknown
+    AttribPointer attrib_pointer[GL_STATE_MAX_ATTRIBS];
+    GLuint cap_enabled[cCapCount];                  // GL_TRUE, GL_FALSE or cUnknown
+    GLenum blend_sfactor;
+    GLenum blend_dfactor;
+} TrackedState;
+
+static const GLStateDispatch cContextDispatch = {
+    glUseProgram,
+    glBindBuffer,
+    glActiveTexture,
+    glBindTexture,
+    glEnableVertexAttribArray,
+    glDisableVertexAttribArray,
+    glVertexAttribPointer,
+    glEnable,
+    glDisable,
+    glBlendFunc,
+    glDeleteBuffers,
+    glDeleteTextures,
+    glGetIntegerv
+};
+
+static GLStateDispatch dispatch = cContextDispatch;
+static TrackedState state;
+static bool stateValid = false;
+static GLStateCounters counters = {0, 0}, totals = {0, 0};
+#ifdef GLSTATE_DEBUG
+static GLStateCounters lastFrameCounters = {-1, -1};
+#endif
+
+void glStateInvalidate()
+{
+    state.program = cUnknown;
+    state.array_buffer = cUnknown;
+    state.element_array_buffer = cUnknown;
+    state.active_texture = cUnknown;
+    for (int unit = 0; unit < GL_STATE_MAX_TEXTURE_UNITS; ++unit)
+    {
+        state.texture_2d[unit] = cUnknown;
+        state.texture_cube_map[unit] = cUnknown;
+    }
+    for (int index = 0; index < GL_STATE_MAX_ATTRIBS; ++index)
+    {
+        state.attrib_enabled[index] = cUnknown;
+        state.attrib_pointer[index].buffer = cUnknown;
+    }
+    for (int cap = 0; cap < cCapCount; ++cap)
+        state.cap_enabled[cap] = cUnknown;
+    state.blend_sfactor = cUnknown;
+    state.blend_dfactor = cUnknown;
+    stateValid = true;
+}
+
+// Whether a call setting *tracked to value can be dropped, else records value
+static bool unchanged(GLuint* tracked, GLuint value)
+{
+    if (!stateValid)
+        glStateInvalidate();
+    if (*tracked == value)
+    {
+        ++counters.filtered;
+        return true;
+    }
+    *tracked = value;
+    ++counters.issued;
+    return false;
+}
+
+// A call the tracking does not cover
+static void untracked()
+{
+    ++counters.issued;
+}
+
+void glStateSetDispatch(const GLStateDispatch* table)
+{
+    dispatch = table ? *table : cContextDispatch;
+    stateValid = false;
+    counters.issued = counters.filtered = 0;
+    #ifdef GLSTATE_DEBUG
+        lastFrameCounters.issued = lastFrameCounters.filtered = -1;
+    #endif
+    totals.issued = totals.filtered = 0;
+}
+
+GLStateCounters glStateEndFrame()
+{
+    GLStateCounters frame = counters;
+    #ifdef GLSTATE_DEBUG
+        if (frame.issued != lastFrameCounters.issued || frame.filtered != lastFrameCounters.filtered)
+            printf("INFO: GL state calls per frame: %d issued, %d filtered\n", frame.issued, frame.filtered);
+        lastFrameCounters = frame;
+    #endif
+    totals.issued += frame.issued;
+    totals.filtered += frame.filtered;
+    counters.issued = counters.filtered = 0;
+    return frame;
+}
+
+GLStateCounters glStateTotals()
+{
+    return totals;
+}
+
+void glStateUseProgram(GLuint program)
+{
+    if (!unchanged(&state.program, program))
+        dispatch.use_program(program);
+}
+
+// Tracked binding of target, NULL if not tracked
+static GLuint* bufferBinding(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER: return &state.array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return &state.element_array_buffer;
+        default: return NULL;
+    }
+}
+
+void glStateBindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint* binding = bufferBinding(target);
+    if (!binding)
+        untracked();
+    else if (unchanged(binding, buffer))
+        return;
+    dispatch.bind_buffer(target, buffer);
+}
+
+void glStateActiveTexture(GLenum texture)
+{
+    if (!unchanged(&state.active_texture, texture))
+        dispatch.active_texture(texture);
+}
+
+// Tracked binding of target on the active unit, NULL if not tracked
+static GLuint* textureBinding(GLenum target)
+{
+    if (state.active_texture == cUnknown)
+    {
+        GLint activeTexture = 0;
+        dispatch.get_integerv(GL_ACTIVE_TEXTURE, &activeTexture);
+        state.active_texture = activeTexture ? (GLenum)activeTexture : cUnknown;
+    }
+    GLuint unit = state.active_texture - GL_TEXTURE0;
+    if (state.active_texture == cUnknown || unit >= GL_STATE_MAX_TEXTURE_UNITS)
+        return NULL;
+    switch (target)
+    {
+        case GL_TEXTURE_2D: return &state.texture_2d[unit];
+        case GL_TEXTURE_CUBE_MAP: return &state.texture_cube_map[unit];
+        default: return NULL;
+    }
+}
+
+void glStateBindTexture(GLenum target, GLuint texture)
+{
+    if (!stateValid)
+        glStateInvalidate();
+    GLuint* binding = textureBinding(target);
+    if (!binding)
+        untracked();
+    else if (unchanged(binding, texture))
+        return;
+    dispatch.bind_texture(target, texture);
+}
+
+void glStateEnableVertexAttribArray(GLuint index)
+{
+    if (index >= GL_STATE_MAX_ATTRIBS)
+        untracked();
+    else if (unchanged(&state.attrib_enabled[index], GL_TRUE))
+        return;
+    dispatch.enable_vertex_attrib_array(index);
+}
+
+void glStateDisableVertexAttribArray(GLuint index)
+{
+    if (index >= GL_STATE_MAX_ATTRIBS)
+        untracked();
+    else if (unchanged(&state.attrib_enabled[index], GL_FALSE))
+        return;
+    dispatch.disable_vertex_attrib_array(index);
+}
+
+void glStateVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                const void* pointer)
+{
+    if (!stateValid)
+        glStateInvalidate();
+    if (index < GL_STATE_MAX_ATTRIBS)
+    {
+        // The attribute sources the buffer bound now, so the same arguments with another
+        // buffer bound are a change
+        AttribPointer& tracked = state.attrib_pointer[index];
+        if (state.array_buffer != cUnknown && tracked.buffer == state.array_buffer && tracked.size == size
+            && tracked.type == type && tracked.normalized == normalized && tracked.stride == stride
+            && tracked.pointer == pointer)
+        {
+            ++counters.filtered;
+            return;
+        }
+        AttribPointer set = {size, type, normalized, stride, pointer, state.array_buffer};
+        tracked = set;
+    }
+    untracked();
+    dispatch.vertex_attrib_pointer(index, size, type, normalized, stride, pointer);
+}
+
+// Tracked enable of cap, NULL if not tracked
+static GLuint* capEnabled(GLenum cap)
+{
+    for (int i = 0; i < cCapCount; ++i)
+        if (cCaps[i] == cap)
+            return &state.cap_enabled[i];
+    return NULL;
+}
+
+void glStateEnable(GLenum cap)
+{
+    GLuint* enabled = capEnabled(cap);
+    if (!enabled)
+        untracked();
+    else if (unchanged(enabled, GL_TRUE))
+        return;
+    dispatch.enable(cap);
+}
+
+void glStateDisable(GLenum cap)
+{
+    GLuint* enabled = capEnabled(cap);
+    if (!enabled)
+        untracked();
+    else if (unchanged(enabled, GL_FALSE))
+        return;
+    dispatch.disable(cap);
+}
+
+void glStateBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    if (!stateValid)
+        glStateInvalidate();
+    if (state.blend_sfactor == sfactor && state.blend_dfactor == dfactor)
+    {
+        ++counters.filtered;
+        return;
+    }
+    state.blend_sfactor = sfactor;
+    state.blend_dfactor = dfactor;
+    untracked();
+    dispatch.blend_func(sfactor, dfactor);
+}
+
+// GL binds 0 in place of a deleted buffer or texture wherever the context binds it.
+// Attributes sourcing a deleted buffer are left unknown.
+void glStateDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    if (!stateValid)
+        glStateInvalidate();
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (buffers[i] == 0)
+            continue;
+        if (state.array_buffer == buffers[i])
+            state.array_buffer = 0;
+        if (state.element_array_buffer == buffers[i])
+            state.element_array_buffer = 0;
+        for (int index = 0; index < GL_STATE_MAX_ATTRIBS; ++index)
+            if (state.attrib_pointer[index].buffer == buffers[i])
+                state.attrib_pointer[index].buffer = cUnknown;
+    }
+    untracked();
+    dispatch.delete_buffers(n, buffers);
+}
+
+void glStateDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    if (!stateValid)
+        glStateInvalidate();
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (textures[i] == 0)
+            continue;
+        for (int unit = 0; unit < GL_STATE_MAX_TEXTURE_UNITS; ++unit)
+        {
+            if (state.texture_2d[unit] == textures[i])
+                state.texture_2d[unit] = 0;
+            if (state.texture_cube_map[unit] == textures[i])
+                state.texture_cube_map[unit] = 0;
+        }
+    }
+    untracked();
+    dispatch.delete_textures(n, textures);
+}
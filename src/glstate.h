@@ -0,0 +1,74 @@
+//
+// GL state tracking shared by the samples: program, buffer and texture binds, vertex
+// attribute arrays and blend state that would not change the context are filtered
+// rather than issued. Under Emscripten every GL call crosses from WASM to JavaScript,
+// and WebGL validates it again, so a redraw re-binding what is already bound pays for
+// nothing.
+//
+// Tracking only holds while every change to the tracked state goes through here, deletes
+// included: GL unbinds deleted buffers and textures, and reuses their names. Call
+// glStateInvalidate after code that changes it directly.
+//
+#pragma once
+#include <SDL_opengles2.h>
+
+// GL entry points the tracking issues calls through, the context's by default. A table
+// recording the calls checks the filtering with no GPU.
+typedef struct {
+    void (GL_APIENTRYP use_program)(GLuint program);
+    void (GL_APIENTRYP bind_buffer)(GLenum target, GLuint buffer);
+    void (GL_APIENTRYP active_texture)(GLenum texture);
+    void (GL_APIENTRYP bind_texture)(GLenum target, GLuint texture);
+    void (GL_APIENTRYP enable_vertex_attrib_array)(GLuint index);
+    void (GL_APIENTRYP disable_vertex_attrib_array)(GLuint index);
+    void (GL_APIENTRYP vertex_attrib_pointer)(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                              GLsizei stride, const void* pointer);
+    void (GL_APIENTRYP enable)(GLenum cap);
+    void (GL_APIENTRYP disable)(GLenum cap);
+    void (GL_APIENTRYP blend_func)(GLenum sfactor, GLenum dfactor);
+    void (GL_APIENTRYP delete_buffers)(GLsizei n, const GLuint* buffers);
+    void (GL_APIENTRYP delete_textures)(GLsizei n, const GLuint* textures);
+    void (GL_APIENTRYP get_integerv)(GLenum pname, GLint* data);
+} GLStateDispatch;
+
+typedef struct {
+    int issued;                 // Calls made through the dispatch table
+    int filtered;               // Calls dropped as not changing the tracked state
+} GLStateCounters;
+
+// Issue calls through dispatch, or the context's entry points if NULL. Forgets the
+// tracked state and counters.
+extern void glStateSetDispatch(
+    const GLStateDispatch* dispatch);
+
+// Forget the tracked state, so the next call of each kind is issued. The active texture
+// unit is queried on the next texture bind.
+extern void glStateInvalidate();
+
+// This frame's counters, reset for the next. With GLSTATE_DEBUG defined in glstate.cpp,
+// also prints them when they differ from the frame before.
+extern GLStateCounters glStateEndFrame();
+
+// Counters summed over the frames ended since the dispatch was set
+extern GLStateCounters glStateTotals();
+
+// As the GL calls of the same name. Binds to targets, texture units, attribute indices
+// and capabilities the tracking does not cover are always issued.
+extern void glStateUseProgram(GLuint program);
+extern void glStateBindBuffer(GLenum target, GLuint buffer);
+extern void glStateActiveTexture(GLenum texture);
+extern void glStateBindTexture(GLenum target, GLuint texture);
+extern void glStateEnableVertexAttribArray(GLuint index);
+extern void glStateDisableVertexAttribArray(GLuint index);
+extern void glStateVertexAttribPointer(
+    GLuint index,
+    GLint size,
+    GLenum type,
+    GLboolean normalized,
+    GLsizei stride,
+    const void* pointer);
+extern void glStateEnable(GLenum cap);
+extern void glStateDisable(GLenum cap);
+extern void glStateBlendFunc(GLenum sfactor, GLenum dfactor);
+extern void glStateDeleteBuffers(GLsizei n, const GLuint* buffers);
+extern void glStateDeleteTextures(GLsizei n, const GLuint* textures);
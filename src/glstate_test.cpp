@@ -0,0 +1,308 @@
+//
+// Checks the GL state tracking of glstate.h against a dispatch table recording the calls
+// issued, no window or GL context needed
+//
+// Build native:
+//     g++ -std=c++11 glstate_test.cpp glstate.cpp -I<SDL2 include dir> -lGLESv2 -o glstate_test
+//
+// Run:
+//     ./glstate_test  (or ctest, see CMakeLists.txt)
+//
+// Result:
+//     OK or ERROR per check, the calls issued and those expected listed on error. Exits
+//     with 1 if any check failed.
+//
+
+#include <stdio.h>
+#include <string>
+
+#include "glstate.h"
+
+// Calls issued through the recording table since the last check, space separated
+std::string issued;
+
+// Active texture unit the recording table's glGetIntegerv reports
+GLint contextActiveTexture = GL_TEXTURE0;
+
+int failures = 0;
+
+std::string enumName(GLenum value)
+{
+    switch (value)
+    {
+        case GL_ARRAY_BUFFER: return "GL_ARRAY_BUFFER";
+        case GL_ELEMENT_ARRAY_BUFFER: return "GL_ELEMENT_ARRAY_BUFFER";
+        case GL_TEXTURE_2D: return "GL_TEXTURE_2D";
+        case GL_TEXTURE_CUBE_MAP: return "GL_TEXTURE_CUBE_MAP";
+        case GL_TEXTURE0: return "GL_TEXTURE0";
+        case GL_TEXTURE1: return "GL_TEXTURE1";
+        case GL_ACTIVE_TEXTURE: return "GL_ACTIVE_TEXTURE";
+        case GL_BLEND: return "GL_BLEND";
+        case GL_SRC_ALPHA: return "GL_SRC_ALPHA";
+        case GL_ONE_MINUS_SRC_ALPHA: return "GL_ONE_MINUS_SRC_ALPHA";
+        case GL_FLOAT: return "GL_FLOAT";
+    }
+    char number[16];
+    snprintf(number, sizeof(number), "%u", value);
+    return number;
+}
+
+std::string number(long value)
+{
+    char text[24];
+    snprintf(text, sizeof(text), "%ld", value);
+    return text;
+}
+
+void record(const std::string& call)
+{
+    issued += issued.empty() ? call : " " + call;
+}
+
+void GL_APIENTRY recordUseProgram(GLuint program)
+{
+    record("glUseProgram(" + number(program) + ")");
+}
+
+void GL_APIENTRY recordBindBuffer(GLenum target, GLuint buffer)
+{
+    record("glBindBuffer(" + enumName(target) + "," + number(buffer) + ")");
+}
+
+void GL_APIENTRY recordActiveTexture(GLenum texture)
+{
+    record("glActiveTexture(" + enumName(texture) + ")");
+}
+
+void GL_APIENTRY recordBindTexture(GLenum target, GLuint texture)
+{
+    record("glBindTexture(" + enumName(target) + "," + number(texture) + ")");
+}
+
+void GL_APIENTRY recordEnableVertexAttribArray(GLuint index)
+{
+    record("glEnableVertexAttribArray(" + number(index) + ")");
+}
+
+void GL_APIENTRY recordDisableVertexAttribArray(GLuint index)
+{
+    record("glDisableVertexAttribArray(" + number(index) + ")");
+}
+
+void GL_APIENTRY recordVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                           GLsizei stride, const void* pointer)
+{
+    record("glVertexAttribPointer(" + number(index) + "," + number(size) + "," + enumName(type) + ","
+           + number(normalized) + "," + number(stride) + "," + number((long)(size_t)pointer) + ")");
+}
+
+void GL_APIENTRY recordEnable(GLenum cap)
+{
+    record("glEnable(" + enumName(cap) + ")");
+}
+
+void GL_APIENTRY recordDisable(GLenum cap)
+{
+    record("glDisable(" + enumName(cap) + ")");
+}
+
+void GL_APIENTRY recordBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    record("glBlendFunc(" + enumName(sfactor) + "," + enumName(dfactor) + ")");
+}
+
+void GL_APIENTRY recordDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        record("glDeleteBuffers(" + number(buffers[i]) + ")");
+}
+
+void GL_APIENTRY recordDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        record("glDeleteTextures(" + number(textures[i]) + ")");
+}
+
+void GL_APIENTRY recordGetIntegerv(GLenum pname, GLint* data)
+{
+    record("glGetIntegerv(" + enumName(pname) + ")");
+    *data = pname == GL_ACTIVE_TEXTURE ? contextActiveTexture : 0;
+}
+
+const GLStateDispatch cRecordingDispatch = {
+    recordUseProgram,
+    recordBindBuffer,
+    recordActiveTexture,
+    recordBindTexture,
+    recordEnableVertexAttribArray,
+    recordDisableVertexAttribArray,
+    recordVertexAttribPointer,
+    recordEnable,
+    recordDisable,
+    recordBlendFunc,
+    recordDeleteBuffers,
+    recordDeleteTextures,
+    recordGetIntegerv
+};
+
+// Compare the calls issued since the last check with expected, then forget them
+void expectIssued(const char* check, const char* expected)
+{
+    if (issued == expected)
+        printf("OK: %s\n", check);
+    else
+    {
+        printf("ERROR: %s\n    issued:   %s\n    expected: %s\n", check, issued.c_str(), expected);
+        ++failures;
+    }
+    issued.clear();
+}
+
+void expectCounters(const char* check, GLStateCounters counters, int issuedCalls, int filteredCalls)
+{
+    if (counters.issued == issuedCalls && counters.filtered == filteredCalls)
+        printf("OK: %s\n", check);
+    else
+    {
+        printf("ERROR: %s, %d issued and %d filtered, expected %d and %d\n", check, counters.issued,
+               counters.filtered, issuedCalls, filteredCalls);
+        ++failures;
+    }
+}
+
+// Start each check from a fresh context: nothing tracked, counters at 0, texture unit 0
+void resetContext()
+{
+    glStateSetDispatch(&cRecordingDispatch);
+    contextActiveTexture = GL_TEXTURE0;
+    issued.clear();
+}
+
+// A redraw, as the samples' redraw functions make it
+void drawFrame()
+{
+    glStateUseProgram(3);
+    glStateBindBuffer(GL_ARRAY_BUFFER, 1);
+    glStateVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateEnableVertexAttribArray(0);
+    glStateBindTexture(GL_TEXTURE_2D, 7);
+    glStateEnable(GL_BLEND);
+    glStateBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void testRedundantCallsFiltered()
+{
+    resetContext();
+    drawFrame();
+    expectIssued("First frame issues every call, querying the active texture unit once",
+                 "glUseProgram(3) glBindBuffer(GL_ARRAY_BUFFER,1) glVertexAttribPointer(0,3,GL_FLOAT,0,0,0) "
+                 "glEnableVertexAttribArray(0) glGetIntegerv(GL_ACTIVE_TEXTURE) glBindTexture(GL_TEXTURE_2D,7) "
+                 "glEnable(GL_BLEND) glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA)");
+    expectCounters("First frame counters", glStateEndFrame(), 7, 0);
+
+    drawFrame();
+    expectIssued("Same frame again issues nothing", "");
+    expectCounters("Same frame again counters", glStateEndFrame(), 0, 7);
+    expectCounters("Totals over both frames", glStateTotals(), 7, 7);
+
+    glStateInvalidate();
+    drawFrame();
+    expectIssued("Frame after glStateInvalidate issues every call again",
+                 "glUseProgram(3) glBindBuffer(GL_ARRAY_BUFFER,1) glVertexAttribPointer(0,3,GL_FLOAT,0,0,0) "
+                 "glEnableVertexAttribArray(0) glGetIntegerv(GL_ACTIVE_TEXTURE) glBindTexture(GL_TEXTURE_2D,7) "
+                 "glEnable(GL_BLEND) glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA)");
+}
+
+void testDeletedNamesReused()
+{
+    resetContext();
+    GLuint buffer = 1, texture = 7;
+    drawFrame();
+    issued.clear();
+
+    // GL binds 0 in place of deleted names, and may hand the same names out again
+    glStateDeleteBuffers(1, &buffer);
+    glStateDeleteTextures(1, &texture);
+    glStateBindBuffer(GL_ARRAY_BUFFER, 0);
+    glStateBindTexture(GL_TEXTURE_2D, 0);
+    expectIssued("Binds of 0 after deleting the bound names are filtered",
+                 "glDeleteBuffers(1) glDeleteTextures(7)");
+
+    glStateBindBuffer(GL_ARRAY_BUFFER, 1);
+    glStateBindTexture(GL_TEXTURE_2D, 7);
+    expectIssued("Binds of reused buffer and texture names are issued",
+                 "glBindBuffer(GL_ARRAY_BUFFER,1) glBindTexture(GL_TEXTURE_2D,7)");
+
+    glStateVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    expectIssued("Attribute pointer sourcing a reused buffer name is issued",
+                 "glVertexAttribPointer(0,3,GL_FLOAT,0,0,0)");
+}
+
+void testAttribPointerBuffer()
+{
+    resetContext();
+    glStateBindBuffer(GL_ARRAY_BUFFER, 1);
+    glStateVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8, 0);
+    glStateVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8, 0);
+    expectIssued("Same attribute pointer and buffer is filtered",
+                 "glBindBuffer(GL_ARRAY_BUFFER,1) glVertexAttribPointer(0,2,GL_FLOAT,0,8,0)");
+
+    glStateBindBuffer(GL_ARRAY_BUFFER, 2);
+    glStateVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8, 0);
+    expectIssued("Same attribute pointer with another GL_ARRAY_BUFFER bound is issued",
+                 "glBindBuffer(GL_ARRAY_BUFFER,2) glVertexAttribPointer(0,2,GL_FLOAT,0,8,0)");
+
+    glStateVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8, 0);
+    glStateVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8, 0);
+    expectIssued("Attribute pointers are tracked per attribute", "glVertexAttribPointer(1,2,GL_FLOAT,0,8,0)");
+}
+
+void testTextureUnits()
+{
+    resetContext();
+    glStateActiveTexture(GL_TEXTURE0);
+    glStateBindTexture(GL_TEXTURE_2D, 7);
+    glStateActiveTexture(GL_TEXTURE1);
+    glStateBindTexture(GL_TEXTURE_2D, 7);
+    glStateBindTexture(GL_TEXTURE_CUBE_MAP, 7);
+    expectIssued("Same texture on another unit or target is issued",
+                 "glActiveTexture(GL_TEXTURE0) glBindTexture(GL_TEXTURE_2D,7) glActiveTexture(GL_TEXTURE1) "
+                 "glBindTexture(GL_TEXTURE_2D,7) glBindTexture(GL_TEXTURE_CUBE_MAP,7)");
+
+    glStateActiveTexture(GL_TEXTURE0);
+    glStateBindTexture(GL_TEXTURE_2D, 7);
+    glStateActiveTexture(GL_TEXTURE1);
+    glStateBindTexture(GL_TEXTURE_2D, 8);
+    expectIssued("Binds are tracked per unit", "glActiveTexture(GL_TEXTURE0) glActiveTexture(GL_TEXTURE1) "
+                 "glBindTexture(GL_TEXTURE_2D,8)");
+
+    // Deleting a texture unbinds it from every unit
+    GLuint texture = 7;
+    glStateDeleteTextures(1, &texture);
+    glStateActiveTexture(GL_TEXTURE0);
+    glStateBindTexture(GL_TEXTURE_2D, 7);
+    expectIssued("Delete forgets the texture on units not active",
+                 "glDeleteTextures(7) glActiveTexture(GL_TEXTURE0) glBindTexture(GL_TEXTURE_2D,7)");
+
+    // Code outside the tracking left unit 1 active
+    glStateInvalidate();
+    contextActiveTexture = GL_TEXTURE1;
+    glStateBindTexture(GL_TEXTURE_2D, 8);
+    glStateBindTexture(GL_TEXTURE_2D, 8);
+    glStateActiveTexture(GL_TEXTURE1);
+    expectIssued("Active unit is queried after glStateInvalidate",
+                 "glGetIntegerv(GL_ACTIVE_TEXTURE) glBindTexture(GL_TEXTURE_2D,8)");
+}
+
+int main()
+{
+    testRedundantCallsFiltered();
+    testDeletedNamesReused();
+    testAttribPointerBuffer();
+    testTextureUnits();
+    glStateSetDispatch(NULL);
+
+    if (failures)
+        printf("ERROR: %d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
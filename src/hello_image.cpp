@@ -1,14 +1,28 @@
 //
-// Emscripten/SDL2/OpenGLES2 sample that displays a checkberboard background texture created from a pixel array
+// Emscripten/SDL2/OpenGLES2 sample that displays a checkberboard background texture created from a pixel array,
+// or the same checkerboard computed by a fragment shader
 //
 // Setup:
 //     Install emscripten: http://kripken.github.io/emscripten-site/docs/getting_started/downloads.html
 //
 // Build:
-//     emcc -std=c++11 hello_image.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s FULL_ES2=1 -s WASM=1 -o ../hello_image.js
+//     emcc -std=c++11 hello_image.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp checkerfill.cpp -msimd128 -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s FULL_ES2=1 -s WASM=1 --preload-file media/rockfont.txf -o ../hello_image.js
+//     Add -pthread -s PTHREAD_POOL_SIZE=4 to fill the texture on several threads; the page must then
+//     be served cross origin isolated for SharedArrayBuffer.
 // 
 // Run:
 //     emrun hello_image.html
+//     emrun hello_image.html --procedural [--verify]
+//     emrun hello_image.html [--on-demand] [--profile[=stats.csv]]
+//     emrun hello_image.html [--record events.log | --replay events.log]
+//     ./hello_image --bench [frames]  (native build, see CMakeLists.txt)
+//
+//     --procedural draws the background with a fragment shader rather than a texture,
+//     --verify checks its first frame against the CPU generated image, pixel for pixel,
+//     --on-demand draws frames only when the view or the content changed,
+//     --profile draws frame time percentiles over the frame, and writes them to the file given,
+//     --bench draws frames (default 600) back to back with the camera moving, and prints timings,
+//     --record logs the input events of each frame, --replay processes a log's in place of the window's
 //
 // Result:
 //     A background image and a colorful triangle.  Left mouse pans, mouse wheel zooms in/out.
@@ -18,22 +32,36 @@
 #include <emscripten.h>
 #endif
 
+#include <vector>
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_opengles2.h>
 
+#include "checkerfill.h"
+#include "demobench.h"
 #include "events.h"
+#include "glstate.h"
+#include "profile.h"
+#include "shadercache.h"
+#include "texture.h"
 
 // Geometry
 GLuint triangleVbo = 0;
 GLuint quadVbo = 0;
 
-// Texture
-SDL_Surface* bgImageTexture = nullptr;
-GLuint textureObj = 0;
+// Texture, with room for a larger image: it grows geometrically, so resizing the
+// window mostly uploads only the newly exposed texels
+Texture bgTexture = {};
+int bgImageWidth = 0, bgImageHeight = 0;
+std::vector<unsigned int> bgRegionPixels;
+
+// Procedural background mode, and verification of its first frame
+bool proceduralBackground = false;
+bool verifyBackground = false;
 
 // Shader vars
 const GLint positionAttrib = 0;
+const char* const cAttribNames[] = {"position", NULL}; // At their attribute index
 GLint shaderPan, shaderZoom, shaderAspect, shaderViewport, shaderImageSize, shaderTexSize;
 GLfloat imageSize[2] = {0.0f, 0.0f}, texSize[2] = {0.0f, 0.0f};
 
@@ -61,9 +89,11 @@ const GLchar* quadVertexSource =
     "    gl_Position.y += 1.0;                                  \n"
     "    gl_Position.y *= 2.0 / viewport.y;                     \n"
     "                                                           \n"
-    "    // Image subrectangle from overall texture             \n"
-    "    texCoord.x = position.x * imageSize.x / texSize.x;     \n"
-    "    texCoord.y = -position.y * imageSize.y / texSize.y;    \n"
+    "    // Image subrectangle from overall texture,            \n"
+    "    // image rows go down from texture row 0               \n"
+    "    texCoord.x = position.x;                               \n"
+    "    texCoord.y = 1.0 - position.y;                         \n"
+    "    texCoord *= imageSize / texSize;                       \n"
     "}                                                          \n";
 
 const GLchar* quadFragmentSource =
@@ -75,6 +105,37 @@ const GLchar* quadFragmentSource =
     "    gl_FragColor = texture2D(texSampler, texCoord);        \n"
     "}                                                          \n";
 
+// Procedural background fragment shader: the checkerboard and border of bgCheckerImage,
+// from gl_FragCoord. Pixel coordinates need highp floats beyond 2048 pixels.
+GLuint procShaderProgram = 0;
+GLint shaderProcViewport, shaderProcImageSize, shaderProcTexSize, shaderProcOrigin, shaderProcSize;
+GLfloat imageOrigin[2] = {0.0f, 0.0f};
+const GLchar* procFragmentSource =
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH                          \n"
+    "precision highp float;                                     \n"
+    "#else                                                      \n"
+    "precision mediump float;                                   \n"
+    "#endif                                                     \n"
+    "uniform vec2 origin;                                       \n"
+    "uniform vec2 size;                                         \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    // Image pixel, rows going down from the top           \n"
+    "    vec2 pixel = floor(gl_FragCoord.xy - origin);          \n"
+    "    pixel.y = size.y - 1.0 - pixel.y;                      \n"
+    "    if (pixel.x == 0.0 || pixel.y == 0.0 ||                \n"
+    "        pixel.x == size.x - 1.0 || pixel.y == size.y - 1.0)\n"
+    "        gl_FragColor = vec4(1.0, 1.0, 0.0, 1.0); // yellow \n"
+    "    else                                                   \n"
+    "    {                                                      \n"
+    "        // Light grey where both or neither are in the     \n"
+    "        // second half of a checker, else dark grey        \n"
+    "        vec2 second = step(50.0, mod(pixel, 100.0));       \n"
+    "        float grey = second.x == second.y ? 196.0 : 128.0; \n"
+    "        gl_FragColor = vec4(vec3(grey / 255.0), 1.0);      \n"
+    "    }                                                      \n"
+    "}                                                          \n";
+
 // Colorful triangle vertex & fragment shaders
 GLuint triShaderProgram = 0;
 const GLchar* triVertexSource =
@@ -104,51 +165,43 @@ void updateShader(EventHandler& eventHandler)
 {
     Camera& camera = eventHandler.camera();
 
-    glUseProgram(quadShaderProgram);
+    glStateUseProgram(quadShaderProgram);
     glUniform2fv(shaderViewport, 1, camera.viewport());
     glUniform2fv(shaderImageSize, 1, imageSize);
     glUniform2fv(shaderTexSize, 1, texSize);
 
-    glUseProgram(triShaderProgram);
+    glStateUseProgram(procShaderProgram);
+    glUniform2fv(shaderProcViewport, 1, camera.viewport());
+    glUniform2fv(shaderProcImageSize, 1, imageSize);
+    glUniform2fv(shaderProcTexSize, 1, texSize);
+    glUniform2fv(shaderProcOrigin, 1, imageOrigin);
+    glUniform2fv(shaderProcSize, 1, imageSize);
+
+    glStateUseProgram(triShaderProgram);
     glUniform2fv(shaderPan, 1, camera.pan());
     glUniform1f(shaderZoom, camera.zoom()); 
     glUniform1f(shaderAspect, camera.aspect());
 }
 
-GLuint initShader(const GLchar* vertexSource, const GLchar* fragmentSource)
-{
-    // Create and compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Create and compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Link vertex and fragment shader into shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glBindAttribLocation(shaderProgram, positionAttrib, "position");
-    glEnableVertexAttribArray(positionAttrib);
-    glLinkProgram(shaderProgram);
-
-    return shaderProgram;
-}
-
 void initShaders(EventHandler& eventHandler)
 {
     // Compile & link shaders
-    quadShaderProgram = initShader(quadVertexSource, quadFragmentSource);
-    triShaderProgram = initShader(triVertexSource, triFragmentSource);
+    quadShaderProgram = shaderCacheProgram(quadVertexSource, quadFragmentSource, cAttribNames);
+    triShaderProgram = shaderCacheProgram(triVertexSource, triFragmentSource, cAttribNames);
+    procShaderProgram = shaderCacheProgram(quadVertexSource, procFragmentSource, cAttribNames);
+    glStateEnableVertexAttribArray(positionAttrib);
 
     // Get shader variables and initalize them
     shaderViewport = glGetUniformLocation(quadShaderProgram, "viewport");
     shaderImageSize = glGetUniformLocation(quadShaderProgram, "imageSize");
     shaderTexSize = glGetUniformLocation(quadShaderProgram, "texSize");
 
+    shaderProcViewport = glGetUniformLocation(procShaderProgram, "viewport");
+    shaderProcImageSize = glGetUniformLocation(procShaderProgram, "imageSize");
+    shaderProcTexSize = glGetUniformLocation(procShaderProgram, "texSize");
+    shaderProcOrigin = glGetUniformLocation(procShaderProgram, "origin");
+    shaderProcSize = glGetUniformLocation(procShaderProgram, "size");
+
     shaderPan = glGetUniformLocation(triShaderProgram, "pan");
     shaderZoom = glGetUniformLocation(triShaderProgram, "zoom");    
     shaderAspect = glGetUniformLocation(triShaderProgram, "aspect");
@@ -160,7 +213,7 @@ void initGeometry()
 {
    // Create vertex buffer objects and copy vertex data into them
     glGenBuffers(1, &quadVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadVbo);
     GLfloat quadVertices[] = 
     {
         0.0f, 1.0f, 0.0f,
@@ -171,7 +224,7 @@ void initGeometry()
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
     glGenBuffers(1, &triangleVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
     GLfloat triangleVertices[] = 
     {
         0.0f, 0.5f, 0.0f,
@@ -186,34 +239,39 @@ int min(int x, int y)
     return x < y ? x : y;
 }
 
-int nextPowerOfTwo(int val)
+int max(int x, int y)
 {
-    int power = 1;
-    while (power < val)
-        power *= 2;
-    return power;
+    return x > y ? x : y;
 }
 
 void freeTexture()
 {
-    // Free existing SDL image and GL texture
-    if (bgImageTexture)
-    {
-        SDL_FreeSurface (bgImageTexture);
-        bgImageTexture = nullptr;
-    }
-    if (textureObj > 0)
-    {
-        glDeleteTextures(1, &textureObj);
-        textureObj = 0;
-    }
+    // Free existing GL texture
+    textureDestroy(&bgTexture);
+    bgImageWidth = bgImageHeight = 0;
 }
 
-void initTexture(EventHandler& eventHandler)
+// Grey checkerboard image with yellow border, the size of the current background image
+CheckerImage bgCheckerImage()
 {
-    freeTexture();
+    CheckerImage image = {bgImageWidth, bgImageHeight, 100, 0xff00ffff, 0xffc4c4c4, 0xff808080};
+    return image;
+}
+
+// Create and upload a w x h region at x,y of the current background image
+void updateImageRegion(int x, int y, int w, int h)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    bgRegionPixels.resize(w * h);
+    CheckerImage image = bgCheckerImage();
+    checkerFill(&image, x, y, w, h, &bgRegionPixels[0]);
+    textureUpdate(&bgTexture, x, y, w, h, &bgRegionPixels[0]);
+}
 
-    // Create background image at size of window
+void initTexture(EventHandler& eventHandler)
+{
+    // Background image at size of window
     int winWidth = eventHandler.camera().windowSize().width,
         winHeight = eventHandler.camera().windowSize().height;
 
@@ -223,77 +281,104 @@ void initTexture(EventHandler& eventHandler)
     winWidth = min(winWidth, maxTextureSize);
     winHeight = min(winHeight, maxTextureSize);
 
-    // Create grey checkerboard image with yellow border
-    int bitsPerPixel = 32;
-    SDL_Surface* bgImage = SDL_CreateRGBSurface(0, winWidth, winHeight, bitsPerPixel, 0, 0, 0, 0);
-    unsigned int* bgImagePixels = (unsigned int*)bgImage->pixels;
-    for (int y = 0; y < bgImage->h; ++y)
-        for (int x = 0; x < bgImage->w; ++x)
+    // Reallocate only when the image outgrows the texture, with 50% to spare
+    // the way it grew, so dragging a window edge reallocates a few times at most
+    int oldWidth = bgImageWidth, oldHeight = bgImageHeight;
+    if (bgTexture.texobj == 0 || winWidth > bgTexture.image_width || winHeight > bgTexture.image_height)
+    {
+        int capacityWidth = winWidth, capacityHeight = winHeight;
+        if (bgTexture.texobj != 0)
         {
-            const int i = x+y*bgImage->w;
-            if (y == 0 || x == 0 || y == bgImage->h-1 || x == bgImage->w - 1)
-                bgImagePixels[i] = 0xff00ffff; // yellow
-            else 
-            {
-                const int checkerSize = 100, halfChecker = checkerSize / 2,
-                        yMod = y % checkerSize, xMod = x % checkerSize;
-                if ((yMod < halfChecker && xMod < halfChecker) 
-                    || (yMod >= halfChecker && xMod >= halfChecker))
-                    bgImagePixels[i] = 0xffc4c4c4; // light grey
-                else
-                    bgImagePixels[i] = 0xff808080; // dark grey
-            }
+            if (winWidth > bgTexture.image_width)
+                capacityWidth = min(max(winWidth, bgTexture.image_width * 3 / 2), maxTextureSize);
+            if (winHeight > bgTexture.image_height)
+                capacityHeight = min(max(winHeight, bgTexture.image_height * 3 / 2), maxTextureSize);
+            capacityWidth = max(capacityWidth, bgTexture.image_width);
+            capacityHeight = max(capacityHeight, bgTexture.image_height);
         }
+        freeTexture();
+        oldWidth = oldHeight = 0;
+        textureCreate(&bgTexture, capacityWidth, capacityHeight, GL_RGBA, TEXTURE_CLAMP, NULL);
+    }
+    bgImageWidth = winWidth;
+    bgImageHeight = winHeight;
 
-    // OpenGLES requires power of 2 dimension textures, so create the smallest
-    // power of 2 image that fits the background image, along with 1 texel border
-    int texWidth = nextPowerOfTwo(bgImage->w + 2),
-        texHeight = nextPowerOfTwo(bgImage->h + 2);
-    bgImageTexture = SDL_CreateRGBSurface(0, texWidth, texHeight, bitsPerPixel, 0, 0, 0, 0);
-
-    // Clear the image and copy the background image into it, centered
-    unsigned int* texPixels = (unsigned int*)bgImageTexture->pixels;
-    memset(texPixels, 0x0, bgImageTexture->w * bgImageTexture->h * bgImageTexture->format->BytesPerPixel);
-    SDL_Rect destRect = {1, bgImageTexture->h - bgImage->h - 1, bgImage->w + 1, bgImageTexture->h - 1};
-    SDL_BlitSurface(bgImage, NULL, bgImageTexture, &destRect);
-    
-    // Build GL texture
-    //
-
-    // Generate a GL texture object and bind it as current
-    glGenTextures(1, &textureObj);
-    glBindTexture(GL_TEXTURE_2D, textureObj);
-
-    // Set the GL texture's wrapping and stretching properties
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    // Upload SDL image to GL texture
-    GLint level = 0, border = 0;
-    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 
-                 bgImageTexture->w, bgImageTexture->h, 
-                 border, GL_RGBA, GL_UNSIGNED_BYTE, bgImageTexture->pixels);
-
-    // Check for errors
-    GLenum glError = glGetError();
-    if (glError != GL_NO_ERROR)
-        printf("ERROR: Texture %d (%dx%d) not built, error code %d\n", textureObj, bgImageTexture->w, bgImageTexture->h, glError);
+    if (oldWidth == 0 || oldHeight == 0)
+        updateImageRegion(0, 0, winWidth, winHeight);
     else
-        printf("OK: Texture %d (%dx%d) built.\n", textureObj, bgImageTexture->w, bgImageTexture->h);
+    {
+        // Newly exposed columns and rows, from the old yellow border on
+        if (winWidth > oldWidth)
+            updateImageRegion(oldWidth - 1, 0, winWidth - oldWidth + 1, winHeight);
+        if (winHeight > oldHeight)
+            updateImageRegion(0, oldHeight - 1, min(oldWidth, winWidth), winHeight - oldHeight + 1);
+
+        // Yellow border at the new right and bottom edges, where not exposed above
+        if (winWidth <= oldWidth)
+            updateImageRegion(winWidth - 1, 0, 1, winHeight);
+        if (winHeight <= oldHeight)
+            updateImageRegion(0, winHeight - 1, winWidth, 1);
+    }
 
     // Unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glStateBindTexture(GL_TEXTURE_2D, 0);
 
     // Update quad shader
-    imageSize[0] = (GLfloat)bgImage->w + 2;
-    imageSize[1] = (GLfloat)bgImage->h + 2;
-    texSize[0] = (GLfloat)bgImageTexture->w;
-    texSize[1] = (GLfloat)bgImageTexture->h;
+    imageSize[0] = (GLfloat)bgImageWidth;
+    imageSize[1] = (GLfloat)bgImageHeight;
+    texSize[0] = (GLfloat)bgTexture.width;
+    texSize[1] = (GLfloat)bgTexture.height;
     updateShader(eventHandler);
+}
 
-    SDL_FreeSurface (bgImage); 
+void initProceduralBackground(EventHandler& eventHandler)
+{
+    // Nothing to build: the shader draws the image at the size of the window
+    Camera& camera = eventHandler.camera();
+    bgImageWidth = camera.windowSize().width;
+    bgImageHeight = camera.windowSize().height;
+
+    // Update quad shader, the image is centered like the texture image
+    imageSize[0] = texSize[0] = (GLfloat)bgImageWidth;
+    imageSize[1] = texSize[1] = (GLfloat)bgImageHeight;
+    imageOrigin[0] = (camera.viewport()[0] - imageSize[0]) / 2.0f;
+    imageOrigin[1] = (camera.viewport()[1] - imageSize[1]) / 2.0f;
+    updateShader(eventHandler);
+}
+
+void initBackground(EventHandler& eventHandler)
+{
+    if (proceduralBackground)
+        initProceduralBackground(eventHandler);
+    else
+        initTexture(eventHandler);
+}
+
+// Read back the procedural background and compare it with checkerPixel, the CPU
+// reference for the texture image, pixel for pixel
+void verifyProceduralBackground()
+{
+    int width = bgImageWidth, height = bgImageHeight;
+    std::vector<unsigned char> rgba(width * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels((int)imageOrigin[0], (int)imageOrigin[1], width, height, GL_RGBA, GL_UNSIGNED_BYTE, &rgba[0]);
+
+    // Rows are read bottom up, image pixels are 0xAABBGGRR; compare color only
+    CheckerImage image = bgCheckerImage();
+    int mismatches = 0;
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+        {
+            const unsigned char* pixel = &rgba[((height - 1 - y) * width + x) * 4];
+            unsigned int expected = checkerPixel(&image, x, y);
+            if (pixel[0] != (expected & 0xff) || pixel[1] != ((expected >> 8) & 0xff) || pixel[2] != ((expected >> 16) & 0xff))
+                ++mismatches;
+        }
+
+    if (mismatches)
+        printf("ERROR: Procedural background %dx%d, %d pixels differ from the CPU generator\n", width, height, mismatches);
+    else
+        printf("OK: Procedural background %dx%d matches the CPU generator\n", width, height);
 }
 
 void redraw(EventHandler& eventHandler)
@@ -304,49 +389,106 @@ void redraw(EventHandler& eventHandler)
     // Clear screen
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Draw the background quad VBO with texture bound and image texture shader
-    glBindTexture(GL_TEXTURE_2D, textureObj);
-    glUseProgram(quadShaderProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
-    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    // Draw the background quad VBO with texture bound and image texture shader,
+    // or with the procedural background shader
+    if (proceduralBackground)
+        glStateUseProgram(procShaderProgram);
+    else
+    {
+        glStateBindTexture(GL_TEXTURE_2D, bgTexture.texobj);
+        glStateUseProgram(quadShaderProgram);
+    }
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glStateVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glStateBindTexture(GL_TEXTURE_2D, 0);
+
+    if (proceduralBackground && verifyBackground)
+    {
+        verifyProceduralBackground();
+        verifyBackground = false;
+    }
 
     // Draw the foreground triangle VBO with a colorful shader
     // No depth buffering here - triangle is in front by virtue of being drawn after quad
-    glUseProgram(triShaderProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
-    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateUseProgram(triShaderProgram);
+    glStateBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
+    glStateVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Frame time percentiles, with --profile
+    Rect& windowSize = eventHandler.camera().windowSize();
+    profileDrawOverlay(windowSize.width, windowSize.height);
     
+    // Count the state calls the redraw issued and those filtered as redundant
+    glStateEndFrame();
+
     // Swap front/back framebuffers
+    ProfileScope swapScope(PROFILE_SWAP);
     eventHandler.swapWindow();
 }
 
 void mainLoop(void* mainLoopArg) 
 {    
     EventHandler& eventHandler = *((EventHandler*)mainLoopArg);
-    eventHandler.processEvents();
+    profileBeginFrame();
+    {
+        ProfileScope eventsScope(PROFILE_EVENTS);
+        eventHandler.processEvents();
+    }
 
-    // Re-initialize texture if window resized
-    if (eventHandler.camera().windowResized())
-        initTexture(eventHandler);
+    // Each flag reads once
+    bool resized = eventHandler.camera().windowResized();
+    bool updated = eventHandler.camera().updated();
+    if (resized || updated)
+    {
+        ProfileScope updateScope(PROFILE_UPDATE);
 
-    // Update shader if camera changed
-    if (eventHandler.camera().updated())
-        updateShader(eventHandler);
+        // Update background if window resized, once however many resize events arrived
+        if (resized)
+            initBackground(eventHandler);
+
+        // Update shader if camera changed
+        if (updated)
+            updateShader(eventHandler);
+    }
 
-    redraw(eventHandler);
+    // Draw only if something changed, when redrawing on demand
+    if (eventHandler.redrawNeeded())
+    {
+        ProfileScope redrawScope(PROFILE_REDRAW);
+        redraw(eventHandler);
+    }
+    profileEndFrame();
 }
 
 int main(int argc, char** argv)
 {
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--procedural") == 0)
+            proceduralBackground = true;
+        else if (strcmp(argv[i], "--verify") == 0)
+            verifyBackground = true;
+    }
+
     EventHandler eventHandler("Hello Image");
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--on-demand") == 0)
+            eventHandler.setRedrawOnDemand(true);
+        else if (strncmp(argv[i], "--profile", 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '='))
+            profileStart("media/rockfont.txf", argv[i][9] == '=' ? argv[i] + 10 : NULL);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            eventHandler.recordEvents(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            eventHandler.replayEvents(argv[++i]);
+    }
 
     // Initialize graphics
     initShaders(eventHandler);
     initGeometry();
-    initTexture(eventHandler);
+    initBackground(eventHandler);
 
     // Start the main loop
     void* mainLoopArg = &eventHandler;
@@ -355,8 +497,12 @@ int main(int argc, char** argv)
     int fps = 0; // Use browser's requestAnimationFrame
     emscripten_set_main_loop_arg(mainLoop, mainLoopArg, fps, true);
 #else
-    while(true) 
-        mainLoop(mainLoopArg);
+    int benchFrames = demoBenchFrames(argc, argv);
+    if (benchFrames > 0)
+        demoBenchRun("hello_image", eventHandler, mainLoop, benchFrames);
+    else
+        while(true) 
+            mainLoop(mainLoopArg);
 #endif
 
     freeTexture();
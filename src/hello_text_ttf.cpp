@@ -1,43 +1,70 @@
 //
-// Emscripten/SDL2/OpenGLES2 sample that displays TrueType text by loading a font and building a string texture 
+// Emscripten/SDL2/OpenGLES2 sample that displays TrueType text by loading a font and building a string texture,
+// and by drawing text through a dynamic signed distance field glyph atlas, which stays sharp as it is zoomed
 //
 // Setup:
 //     Install emscripten: http://kripken.github.io/emscripten-site/docs/getting_started/downloads.html
 //
 // Build:
-//     emcc -std=c++11 hello_text_ttf.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_TTF=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/LiberationSansBold.ttf -o hello_text_ttf.html
+//     emcc -std=c++11 hello_text_ttf.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp ttfatlas.cpp texture.cpp mipmap.cpp -s USE_SDL=2 -s USE_SDL_TTF=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/LiberationSansBold.ttf --preload-file media/rockfont.txf -o hello_text_ttf.html
 // 
 // Run:
 //     emrun hello_text_ttf.html
+//     emrun hello_text_ttf.html [--on-demand] [--profile[=stats.csv]]
+//     emrun hello_text_ttf.html [--record events.log | --replay events.log]
+//     ./hello_text_ttf --bench [frames]  (native build, see CMakeLists.txt)
+//
+//     --on-demand draws frames only when the view or the content changed,
+//     --profile draws frame time percentiles over the frame, and writes them to the file given,
+//     --bench draws frames (default 600) back to back with the camera moving, and prints timings,
+//     --record logs the input events of each frame, --replay processes a log's in place of the window's
 //
 // Result:
-//     A TTF text quad and colorful triangle.  Left mouse pans, mouse wheel zooms in/out.
+//     A TTF text quad, atlas text with a frame counter, and colorful triangle.  Left mouse pans, mouse wheel zooms in/out.
 //
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
+#include <vector>
 #include <SDL.h>
 #include <SDL_ttf.h>
 #include <SDL_opengles2.h>
 
+#include "demobench.h"
 #include "events.h"
+#include "glstate.h"
+#include "profile.h"
+#include "shadercache.h"
+#include "texture.h"
+#include "ttfatlas.h"
 
 // Geometry
 GLuint triangleVbo = 0;
 GLuint quadVbo = 0;
 
 // Texture
-GLuint textureObj = 0;
+Texture textTexture = {};
 
 // Text
 const char* cFontName = "media/LiberationSansBold.ttf";
 const int cFontPointSize = 64;
 const char* message = "Hello Text";
 
+// Glyph atlas text, glyphs rasterized as first drawn
+const int cAtlasSize = 512;
+const int cAtlasSpread = 6;
+TTF_Font* atlasFont = nullptr;
+TtfAtlas* textAtlas = nullptr;
+TxfTextBatch* textBatch = nullptr;
+unsigned int frameCount = 0;
+
 // Shader vars
-const GLint positionAttrib = 0;
+const GLint positionAttrib = TXF_ATTRIB_POSITION,
+            texCoordAttrib = TXF_ATTRIB_TEXCOORD,
+            offsetAttrib = TXF_ATTRIB_OFFSET;
+const char* const cAttribNames[] = {"position", "texCoord", "offset", NULL}; // At their attribute index
 GLint shaderPan, shaderZoom, shaderAspect, shaderViewport, shaderTextSize, shaderTexSize;
 GLfloat textSize[2] = {0.0f, 0.0f}, texSize[2] = {0.0f, 0.0f};
 
@@ -65,9 +92,11 @@ const GLchar* quadVertexSource =
     "    gl_Position.y += 1.0;                                  \n"
     "    gl_Position.y *= 2.0 / viewport.y;                     \n"
     "                                                           \n"
-    "    // Text subrectangle from overall texture              \n"
-    "    texCoord.x = position.x * textSize.x / texSize.x;      \n"
-    "    texCoord.y = -position.y * textSize.y / texSize.y;     \n"
+    "    // Text subrectangle from overall texture,             \n"
+    "    // text rows go down from texture row 0                \n"
+    "    texCoord.x = position.x;                               \n"
+    "    texCoord.y = 1.0 - position.y;                         \n"
+    "    texCoord *= textSize / texSize;                        \n"
     "}                                                          \n";
 
 const GLchar* quadFragmentSource =
@@ -76,7 +105,48 @@ const GLchar* quadFragmentSource =
     "uniform sampler2D texSampler;                              \n"
     "void main()                                                \n"
     "{                                                          \n"
-    "    gl_FragColor = texture2D(texSampler, texCoord);        \n"
+    "    // Translucent gray background, opaque white text      \n"
+    "    float alpha = texture2D(texSampler, texCoord).a;       \n"
+    "    gl_FragColor = mix(vec4(0.5), vec4(1.0), alpha);       \n"
+    "}                                                          \n";
+
+// Atlas text quads vertex & fragment shaders, quads in texels placed by offset
+GLuint textShaderProgram = 0;
+GLint shaderTextViewport, shaderTextZoom, shaderTextSmoothing;
+const GLchar* textVertexSource =
+    "uniform vec2 viewport;                                     \n"
+    "uniform float zoom;                                        \n"
+    "attribute vec4 position;                                   \n"
+    "attribute vec2 texCoord;                                   \n"
+    "attribute vec2 offset;                                     \n"
+    "varying vec2 vTexCoord;                                    \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    gl_Position = vec4(position.xyz, 1.0);                 \n"
+    "    gl_Position.xy += offset;                              \n"
+    "    gl_Position.xy *= zoom;                                \n"
+    "                                                           \n"
+    "    // Ortho projection                                    \n"
+    "    gl_Position.x += 1.0;                                  \n"
+    "    gl_Position.x *= 2.0 / viewport.x;                     \n"
+    "    gl_Position.y += 1.0;                                  \n"
+    "    gl_Position.y *= 2.0 / viewport.y;                     \n"
+    "                                                           \n"
+    "    vTexCoord = texCoord;                                  \n"
+    "}                                                          \n";
+
+const GLchar* textFragmentSource =
+    "precision mediump float;                                   \n"
+    "varying vec2 vTexCoord;                                    \n"
+    "uniform sampler2D texSampler;                              \n"
+    "uniform float smoothing;                                   \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    // White text, antialiased about the 0.5 distance edge \n"
+    "    float distance = texture2D(texSampler, vTexCoord).a;   \n"
+    "    float alpha = smoothstep(0.5 - smoothing,              \n"
+    "                             0.5 + smoothing, distance);   \n"
+    "    gl_FragColor = vec4(1.0, 1.0, 1.0, alpha);             \n"
     "}                                                          \n";
 
 // Colorful triangle vertex & fragment shaders
@@ -104,62 +174,43 @@ const GLchar* triFragmentSource =
     "    gl_FragColor = vec4 ( color, 1.0 );      \n"
     "}                                            \n";
 
-int nextPowerOfTwo(int val)
-{
-    int power = 1;
-    while (power < val)
-        power *= 2;
-    return power;
-}
-
 void updateShader(EventHandler& eventHandler)
 {
     Camera& camera = eventHandler.camera();
 
-    glUseProgram(quadShaderProgram);
+    glStateUseProgram(quadShaderProgram);
     glUniform2fv(shaderViewport, 1, camera.viewport());
     glUniform2fv(shaderTextSize, 1, textSize);
     glUniform2fv(shaderTexSize, 1, texSize);
 
-    glUseProgram(triShaderProgram);
+    glStateUseProgram(textShaderProgram);
+    glUniform2fv(shaderTextViewport, 1, camera.viewport());
+    glUniform1f(shaderTextZoom, camera.zoom());
+
+    // Distance field values change by 0.5 / spread per texel, a texel is zoom pixels
+    glUniform1f(shaderTextSmoothing, 0.5f / (cAtlasSpread * camera.zoom()));
+
+    glStateUseProgram(triShaderProgram);
     glUniform2fv(shaderPan, 1, camera.pan());
     glUniform1f(shaderZoom, camera.zoom()); 
     glUniform1f(shaderAspect, camera.aspect());
 }
 
-GLuint initShader(const GLchar* vertexSource, const GLchar* fragmentSource)
-{
-    // Create and compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Create and compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Link vertex and fragment shader into shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glBindAttribLocation(shaderProgram, positionAttrib, "position");
-    glEnableVertexAttribArray(positionAttrib);
-    glLinkProgram(shaderProgram);
-
-    return shaderProgram;
-}
-
 void initShaders(EventHandler& eventHandler)
 {
     // Compile & link shaders
-    quadShaderProgram = initShader(quadVertexSource, quadFragmentSource);
-    triShaderProgram = initShader(triVertexSource, triFragmentSource);
+    quadShaderProgram = shaderCacheProgram(quadVertexSource, quadFragmentSource, cAttribNames);
+    triShaderProgram = shaderCacheProgram(triVertexSource, triFragmentSource, cAttribNames);
+    textShaderProgram = shaderCacheProgram(textVertexSource, textFragmentSource, cAttribNames);
+    glStateEnableVertexAttribArray(positionAttrib);
 
     // Get shader variables and initalize them
     shaderViewport = glGetUniformLocation(quadShaderProgram, "viewport");
     shaderTextSize = glGetUniformLocation(quadShaderProgram, "textSize");
     shaderTexSize = glGetUniformLocation(quadShaderProgram, "texSize");
+    shaderTextViewport = glGetUniformLocation(textShaderProgram, "viewport");
+    shaderTextZoom = glGetUniformLocation(textShaderProgram, "zoom");
+    shaderTextSmoothing = glGetUniformLocation(textShaderProgram, "smoothing");
 
     shaderPan = glGetUniformLocation(triShaderProgram, "pan");
     shaderZoom = glGetUniformLocation(triShaderProgram, "zoom");    
@@ -172,7 +223,7 @@ void initGeometry()
 {
    // Create vertex buffer objects and copy vertex data into them
     glGenBuffers(1, &quadVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadVbo);
     GLfloat quadVertices[] = 
     {
         0.0f, 1.0f, 0.0f,
@@ -183,7 +234,7 @@ void initGeometry()
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
     glGenBuffers(1, &triangleVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
     GLfloat triangleVertices[] = 
     {
         0.0f, 0.5f, 0.0f,
@@ -204,6 +255,32 @@ void debugPrintSurface(SDL_Surface* surface, const char* name, bool dumpPixels)
     }
 }
 
+// Glyph coverage of a TTF_RenderText_* surface as 8-bit alpha, written to dst rows of
+// dstStride bytes. Solid (8-bit palettized) text is a palette index per pixel, with
+// index 0 the background; Blended (32-bit) text has coverage in its alpha channel.
+void textCoverageToAlpha(SDL_Surface* textImage, unsigned char* dst, int dstStride)
+{
+    const int bytesPerPixel = textImage->format->BytesPerPixel;
+    for (int row = 0; row < textImage->h; ++row)
+    {
+        const Uint8* src = (const Uint8*)textImage->pixels + row * textImage->pitch;
+        unsigned char* alpha = dst + row * dstStride;
+        if (bytesPerPixel == 1)
+        {
+            for (int col = 0; col < textImage->w; ++col)
+                alpha[col] = src[col] ? 0xff : 0x00;
+        }
+        else if (bytesPerPixel == 4)
+        {
+            const Uint32 amask = textImage->format->Amask;
+            const int ashift = textImage->format->Ashift;
+            const Uint32* pixels = (const Uint32*)src;
+            for (int col = 0; col < textImage->w; ++col)
+                alpha[col] = (Uint8)((pixels[col] & amask) >> ashift);
+        }
+    }
+}
+
 void initTextTexture(EventHandler& eventHandler)
 {
     TTF_Init();
@@ -214,123 +291,166 @@ void initTextTexture(EventHandler& eventHandler)
     {
         // Render text to surface
         SDL_Color foregroundColor = {255,255,255,255};
-        SDL_Surface* textImage8Bit = TTF_RenderText_Solid(font, message, foregroundColor);
+        SDL_Surface* textImage = TTF_RenderText_Solid(font, message, foregroundColor);
         
-        if (textImage8Bit)
+        if (textImage && (textImage->format->BytesPerPixel == 1 || textImage->format->BytesPerPixel == 4))
         {
-            // Convert surface from 8 to 32 bit for GL
-            SDL_Surface* textImage = SDL_ConvertSurfaceFormat(textImage8Bit, SDL_PIXELFORMAT_RGBA8888, 0);
             debugPrintSurface(textImage, "textImage", false);
 
-            // Create power of 2 dimensioned texture for GL with 1 texel border, clear it, and copy text image into it
-            SDL_Surface* texture = SDL_CreateRGBSurface(0, nextPowerOfTwo(textImage->w + 2), nextPowerOfTwo(textImage->h + 2), 
-                                                        textImage->format->BitsPerPixel, 0, 0, 0, 0);
-            memset(texture->pixels, 0x0, texture->w * texture->h * texture->format->BytesPerPixel);
-            SDL_Rect destRect = {1, texture->h - textImage->h - 1, textImage->w + 1, texture->h - 1};
-            SDL_SetSurfaceBlendMode(textImage, SDL_BLENDMODE_NONE);
-            SDL_BlitSurface(textImage, NULL, texture, &destRect);
- 
-            // Emscripten/SDL bug? SDL_BlitSurface should copy source alpha when source surface is set to 
-            // SDL_BLENDMODE_NONE, however this is not happening, so fix it up here
-            unsigned int* pixels = (unsigned int*)texture->pixels;
-            for (int i = 0; i < texture->w*texture->h; ++i)
-            {
-                if (pixels[i] != 0)
-                    pixels[i] |= 0xff000000;
-                else
-                    pixels[i] = 0x80808080;
-            }
-            debugPrintSurface(texture, "texture", false);
-
-            // Determine GL texture format
-            GLint format = -1;
-            if (texture->format->BitsPerPixel == 24)
-                format = GL_RGB;
-            else if (texture->format->BitsPerPixel == 32)
-                format = GL_RGBA;
-
-            if (format != -1)
-            {
-                // Enable blending for texture alpha component
-                glEnable( GL_BLEND );
-                glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-
-                // Generate a GL texture object
-                glGenTextures(1, &textureObj);
-
-                // Bind GL texture
-                glBindTexture(GL_TEXTURE_2D, textureObj);
-
-                // Set the GL texture's wrapping and stretching properties
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-                // Copy SDL surface image to GL texture
-                glTexImage2D(GL_TEXTURE_2D, 0, format, 
-                             texture->w, texture->h, 
-                             0, format, GL_UNSIGNED_BYTE, texture->pixels);
-
-                // Update quad shader
-                texSize[0] = (GLfloat)texture->w;
-                texSize[1] = (GLfloat)texture->h;
-                textSize[0] = (GLfloat)textImage->w + 2;
-                textSize[1] = (GLfloat)textImage->h + 2;
-                updateShader(eventHandler);
-            }
-                                    
+            // GL_ALPHA texture with 1 texel border: one byte per texel rather than RGBA,
+            // and text coverage is written straight into it. The quad shader maps
+            // alpha 0 to the translucent gray background and 1 to opaque white text.
+            int textWidth = textImage->w + 2, textHeight = textImage->h + 2;
+            std::vector<unsigned char> texels(textWidth * textHeight, 0);
+            if (SDL_MUSTLOCK(textImage))
+                SDL_LockSurface(textImage);
+            textCoverageToAlpha(textImage, &texels[textWidth + 1], textWidth);
+            if (SDL_MUSTLOCK(textImage))
+                SDL_UnlockSurface(textImage);
+
+            // Enable blending for texture alpha component
+            glStateEnable( GL_BLEND );
+            glStateBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+            // Copy text coverage to GL texture, exact size when the context allows it, with
+            // mipmaps box filtered on the CPU for trilinear sampling when zoomed out
+            textureCreate(&textTexture, textWidth, textHeight, GL_ALPHA, TEXTURE_LINEAR | TEXTURE_CPU_MIPMAPS, &texels[0]);
+
+            // Update quad shader
+            texSize[0] = (GLfloat)textTexture.width;
+            texSize[1] = (GLfloat)textTexture.height;
+            textSize[0] = (GLfloat)textTexture.image_width;
+            textSize[1] = (GLfloat)textTexture.image_height;
+            updateShader(eventHandler);
+        }
+
+        if (textImage)
             SDL_FreeSurface (textImage);        
-            SDL_FreeSurface (texture);        
-        }  
         TTF_CloseFont(font);
     }
     else
         printf("Failed to load font %s, due to %s\n", cFontName, TTF_GetError());
 }
 
+void initTextAtlas()
+{
+    // The atlas rasterizes glyphs on demand, so its font stays open
+    atlasFont = TTF_OpenFont(cFontName, cFontPointSize);
+    if (atlasFont)
+    {
+        textAtlas = ttfCreateAtlas(atlasFont, cAtlasSize, cAtlasSize, cAtlasSpread);
+        textBatch = txfCreateTextBatch(textAtlas->txf);
+    }
+    else
+        printf("Failed to load font %s, due to %s\n", cFontName, TTF_GetError());
+}
+
+void destroyTextAtlas()
+{
+    txfDestroyTextBatch(textBatch);
+    ttfDestroyAtlas(textAtlas);
+    if (atlasFont)
+        TTF_CloseFont(atlasFont);
+}
+
+void drawAtlasText()
+{
+    char frameText[32];
+    snprintf(frameText, sizeof(frameText), "Frame %u", frameCount++);
+
+    // Only glyphs not seen before are rasterized, and only their rows uploaded
+    ttfAtlasAddText(textAtlas, message);
+    ttfAtlasAddText(textAtlas, frameText);
+    ttfAtlasUpload(textAtlas);
+
+    glStateEnableVertexAttribArray(texCoordAttrib);
+    glStateUseProgram(textShaderProgram);
+    txfBeginTextBatch(textBatch);
+    txfBatchString(textBatch, message, -txfGetStringWidth(textAtlas->txf, message, strlen(message)) / 2.0f, -cFontPointSize * 1.5f);
+    txfBatchString(textBatch, frameText, -txfGetStringWidth(textAtlas->txf, frameText, strlen(frameText)) / 2.0f, -cFontPointSize * 2.5f);
+    txfFlushTextBatch(textBatch);
+    glStateDisableVertexAttribArray(texCoordAttrib);
+}
+
 void redraw(EventHandler& eventHandler)
 {
     // Clear screen
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Draw the triangle VBO with a colorful shader
-    glUseProgram(triShaderProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
-    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateUseProgram(triShaderProgram);
+    glStateBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
+    glStateVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLES, 0, 3);
     
     // Draw the quad VBO with a text texture shader
-    glUseProgram(quadShaderProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
-    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateUseProgram(quadShaderProgram);
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glStateVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateBindTexture(GL_TEXTURE_2D, textTexture.texobj);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
+    // Draw text through the glyph atlas
+    if (textAtlas)
+        drawAtlasText();
+
+    // Frame time percentiles, with --profile
+    Rect& windowSize = eventHandler.camera().windowSize();
+    profileDrawOverlay(windowSize.width, windowSize.height);
+
+    // Count the state calls the redraw issued and those filtered as redundant
+    glStateEndFrame();
+
     // Swap front/back framebuffers
+    ProfileScope swapScope(PROFILE_SWAP);
     eventHandler.swapWindow();
 }
 
 void mainLoop(void* mainLoopArg) 
 {    
     EventHandler& eventHandler = *((EventHandler*)mainLoopArg);
-    eventHandler.processEvents();
+    profileBeginFrame();
+    {
+        ProfileScope eventsScope(PROFILE_EVENTS);
+        eventHandler.processEvents();
+    }
 
     // Update shader if camera changed
     if (eventHandler.camera().updated())
+    {
+        ProfileScope updateScope(PROFILE_UPDATE);
         updateShader(eventHandler);
+    }
 
-    redraw(eventHandler);
+    // Draw only if something changed, when redrawing on demand
+    if (eventHandler.redrawNeeded())
+    {
+        ProfileScope redrawScope(PROFILE_REDRAW);
+        redraw(eventHandler);
+    }
+    profileEndFrame();
 }
 
 int main(int argc, char** argv)
 {
     EventHandler eventHandler("Hello TTF Text");
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--on-demand") == 0)
+            eventHandler.setRedrawOnDemand(true);
+        else if (strncmp(argv[i], "--profile", 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '='))
+            profileStart("media/rockfont.txf", argv[i][9] == '=' ? argv[i] + 10 : NULL);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            eventHandler.recordEvents(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            eventHandler.replayEvents(argv[++i]);
+    }
 
     // Initialize graphics
     initShaders(eventHandler);
     initGeometry();
     initTextTexture(eventHandler);
+    initTextAtlas();
 
     // Start the main loop
     void* mainLoopArg = &eventHandler;
@@ -339,11 +459,16 @@ int main(int argc, char** argv)
     int fps = 0; // Use browser's requestAnimationFrame
     emscripten_set_main_loop_arg(mainLoop, mainLoopArg, fps, true);
 #else
-    while(true) 
-        mainLoop(mainLoopArg);
+    int benchFrames = demoBenchFrames(argc, argv);
+    if (benchFrames > 0)
+        demoBenchRun("hello_text_ttf", eventHandler, mainLoop, benchFrames);
+    else
+        while(true) 
+            mainLoop(mainLoopArg);
 #endif
 
-    glDeleteTextures(1, &textureObj);
+    textureDestroy(&textTexture);
+    destroyTextAtlas();
 
     return 0;
 }
\ No newline at end of file
@@ -1,17 +1,26 @@
 //
-// Emscripten/SDL2/OpenGLES2 sample that displays Texfont text by loading a font and building a texture atlas
+// Emscripten/SDL2/OpenGLES2 sample that displays Texfont text by loading a font and building a texture atlas.
+// The font is a signed distance field (made with txf2sdf), so text stays sharp as it is zoomed.
 //
 // Setup:
 //     Install emscripten: http://kripken.github.io/emscripten-site/docs/getting_started/downloads.html
 //
 // Build:
-//     emcc -std=c++11 hello_text_txf.cpp events.cpp camera.cpp texfont.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o hello_text_txf.html
+//     emcc -std=c++11 hello_text_txf.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont_sdf.txf --preload-file media/rockfont.txf -o hello_text_txf.html
 // 
 // Run:
 //     emrun hello_text_txf.html
+//     emrun hello_text_txf.html [--on-demand] [--profile[=stats.csv]]
+//     emrun hello_text_txf.html [--record events.log | --replay events.log]
+//     ./hello_text_txf --bench [frames]  (native build, see CMakeLists.txt)
+//
+//     --on-demand draws frames only when the view or the content changed,
+//     --profile draws frame time percentiles over the frame, and writes them to the file given,
+//     --bench draws frames (default 600) back to back with the camera moving, and prints timings,
+//     --record logs the input events of each frame, --replay processes a log's in place of the window's
 //
 // Result:
-//     A TXF font quad and colorful triangle.  Left mouse pans, mouse wheel zooms in/out.
+//     A TXF font quad, zoomable text and colorful triangle.  Left mouse pans, mouse wheel zooms in/out.
 //
 
 #ifdef __EMSCRIPTEN__
@@ -21,26 +30,39 @@
 #include <SDL.h>
 #include <SDL_opengles2.h>
 
+#include "demobench.h"
 #include "events.h"
+#include "glstate.h"
+#include "mipmap.h"
+#include "profile.h"
+#include "shadercache.h"
 #include "texfont.h"
+#include "texture.h"
 
 // Vertex attribute indices for all shaders
-const GLuint vertexPositionIndex = 0, 
-             vertexTexCoordIndex = 1;
+const GLuint vertexPositionIndex = TXF_ATTRIB_POSITION, 
+             vertexTexCoordIndex = TXF_ATTRIB_TEXCOORD,
+             vertexOffsetIndex = TXF_ATTRIB_OFFSET;
+const char* const cAttribNames[] = {"position", "texCoord", "offset", NULL};
 
 // Text quads geometry and vertex shader
 GLuint quadsTextShaderProgram = 0;
 GLint shaderViewport2;
 GLint shaderTextureSampler2;
+GLint shaderTextZoom, shaderTextSmoothing;
 
 const GLchar* quadsTextVertexSource =
     "uniform vec2 viewport;                                     \n"
+    "uniform float zoom;                                        \n"
     "attribute vec4 position;                                   \n"
     "attribute vec2 texCoord;                                   \n"
+    "attribute vec2 offset;                                     \n"
     "varying vec2 vTexCoord;                                    \n"    
     "void main()                                                \n"
     "{                                                          \n"
     "    gl_Position = vec4(position.xyz, 1.0);                 \n"
+    "    gl_Position.xy += offset;                              \n"
+    "    gl_Position.xy *= zoom;                                \n"
     "                                                           \n"
     "    // Ortho projection                                    \n"
     "    gl_Position.x += 1.0;                                  \n"
@@ -52,8 +74,9 @@ const GLchar* quadsTextVertexSource =
     "}                                                          \n";
 
 // Font quad texture, geometry, and vertex shader
-const char* cFontName = "media/rockfont.txf";
+const char* cFontName = "media/rockfont_sdf.txf";
 TexFont* texFont = nullptr;
+TxfTextBatch* textBatch = nullptr;
 GLuint quadFontVbo = 0;
 GLuint quadFontShaderProgram = 0;
 GLfloat fontSize[2] = {0.0f, 0.0f};
@@ -97,6 +120,21 @@ const GLchar* fontFragmentSource =
     "    gl_FragColor.xyz = vec3(1.0, 1.0, 1.0);                \n"
     "}                                                          \n";
 
+// Text quads fragment shader: the distance field edge is at 0.5, antialiased over
+// about a screen pixel, which is smoothing in distance field units
+const GLchar* textFragmentSource =
+    "precision mediump float;                                   \n"
+    "uniform sampler2D texSampler;                              \n"
+    "uniform float smoothing;                                   \n"
+    "varying vec2 vTexCoord;                                    \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    float distance = texture2D(texSampler, vTexCoord).a;   \n"
+    "    float alpha = smoothstep(0.5 - smoothing,              \n"
+    "                             0.5 + smoothing, distance);   \n"
+    "    gl_FragColor = vec4(1.0, 1.0, 1.0, alpha);             \n"
+    "}                                                          \n";
+
 // Colorful triangle geometry, vertex & fragment shaders
 GLuint triangleVbo = 0;
 GLuint triShaderProgram = 0;
@@ -128,62 +166,39 @@ void updateShader(EventHandler& eventHandler)
 {
     Camera& camera = eventHandler.camera();
 
-    glUseProgram(quadsTextShaderProgram);
+    glStateUseProgram(quadsTextShaderProgram);
     glUniform2fv(shaderViewport2, 1, camera.viewport());
     glUniform1i(shaderTextureSampler2, 0);
+    glUniform1f(shaderTextZoom, camera.zoom());
 
-    glUseProgram(quadFontShaderProgram);
+    // Distance field values change by 0.5 / spread per texel, a texel is zoom pixels.
+    // Plain alpha fonts only use 0 and 1.
+    int spread = texFont ? texFont->sdf_spread : 0;
+    glUniform1f(shaderTextSmoothing, spread > 0 ? 0.5f / (spread * camera.zoom()) : 0.5f);
+
+    glStateUseProgram(quadFontShaderProgram);
     glUniform2fv(shaderViewport, 1, camera.viewport());
     glUniform2fv(shaderFontSize, 1, fontSize);
     glUniform1i(shaderTextureSampler, 0);
 
-    glUseProgram(triShaderProgram);
+    glStateUseProgram(triShaderProgram);
     glUniform2fv(shaderPan, 1, camera.pan());
     glUniform1f(shaderZoom, camera.zoom()); 
     glUniform1f(shaderAspect, camera.aspect());
 }
 
-GLuint buildShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource, bool bUseTexCoords)
-{
-    // Create and compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Create and compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Link vertex and fragment shader into shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glBindAttribLocation(shaderProgram, vertexPositionIndex, "position");
-    if (bUseTexCoords)
-        glBindAttribLocation(shaderProgram, vertexTexCoordIndex, "texCoord");
-    
-    glLinkProgram(shaderProgram);
-
-    GLenum glError = glGetError();
-    if (glError != GL_NO_ERROR)
-        printf("ERROR: Shader %d failed to build, error code %d\n", shaderProgram, glError);
-    else
-        printf("Shader %d built OK.\n", shaderProgram);
-
-    return shaderProgram;
-}
-
 void initShaders(EventHandler& eventHandler)
 {
     // Compile & link shaders
-    quadsTextShaderProgram = buildShaderProgram(quadsTextVertexSource, fontFragmentSource, true);
-    quadFontShaderProgram = buildShaderProgram(quadFontVertexSource, fontFragmentSource, false);
-    triShaderProgram = buildShaderProgram(triVertexSource, triFragmentSource, false);
+    quadsTextShaderProgram = shaderCacheProgram(quadsTextVertexSource, textFragmentSource, cAttribNames);
+    quadFontShaderProgram = shaderCacheProgram(quadFontVertexSource, fontFragmentSource, cAttribNames);
+    triShaderProgram = shaderCacheProgram(triVertexSource, triFragmentSource, cAttribNames);
 
     // Get shader uniforms and initialize them
     shaderViewport2 = glGetUniformLocation(quadsTextShaderProgram, "viewport");
     shaderTextureSampler2 = glGetUniformLocation(quadsTextShaderProgram, "texSampler");
+    shaderTextZoom = glGetUniformLocation(quadsTextShaderProgram, "zoom");
+    shaderTextSmoothing = glGetUniformLocation(quadsTextShaderProgram, "smoothing");
 
     shaderViewport = glGetUniformLocation(quadFontShaderProgram, "viewport");
     shaderFontSize = glGetUniformLocation(quadFontShaderProgram, "fontSize");
@@ -200,7 +215,7 @@ void initGeometry()
 {
    // Create vertex buffer objects and copy vertex data into them
     glGenBuffers(1, &quadFontVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, quadFontVbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadFontVbo);
     GLfloat quadVertices[] = 
     {
         0.0f, 1.0f, 0.0f,
@@ -211,7 +226,7 @@ void initGeometry()
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
     glGenBuffers(1, &triangleVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
     GLfloat triangleVertices[] = 
     {
         0.0f, 0.5f, 0.0f,
@@ -240,18 +255,35 @@ void initFontTexture(EventHandler& eventHandler)
         printf("texFont dimensions %dx%d\n", texFont->tex_width, texFont->tex_height);
 
         // Enable blending for texture alpha component
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glStateEnable(GL_BLEND);
+        glStateBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         // Generate, bind, and upload font texture
         txfEstablishTexture(texFont, 0);
 
-        // Set the GL texture's wrapping and stretching properties
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        // All text strings are drawn through one batch per frame
+        textBatch = txfCreateTextBatch(texFont);
+
+        // Distance fields are interpolated, then thresholded by the text shader. Minified
+        // text is sampled trilinear from mipmaps rather than aliasing, where the context
+        // can mipmap the font texture's size. The texture stays the font's.
+        Texture fontTexture = {};
+        fontTexture.texobj = texFont->texobj;
+        fontTexture.format = GL_ALPHA;
+        fontTexture.image_width = fontTexture.width = texFont->tex_width;
+        fontTexture.image_height = fontTexture.height = texFont->tex_height;
+        fontTexture.levels = 1;
+        int flags = TEXTURE_CLAMP | TEXTURE_MIPMAPS | (texFont->format == TXF_FORMAT_SDF ? TEXTURE_LINEAR : 0);
+        bool pot = (fontTexture.width & (fontTexture.width - 1)) == 0
+                   && (fontTexture.height & (fontTexture.height - 1)) == 0;
+        if (pot || textureNPOTAllowed(flags))
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            fontTexture.levels = mipmapLevels(fontTexture.width, fontTexture.height);
+        }
+        else
+            printf("INFO: Font texture %dx%d not mipmapped, NPOT\n", fontTexture.width, fontTexture.height);
+        textureSetSampler(&fontTexture, flags);
 
         fontSize[0] = (GLfloat)texFont->tex_width;
         fontSize[1] = (GLfloat)texFont->tex_height;
@@ -265,6 +297,7 @@ void initFontTexture(EventHandler& eventHandler)
 
 void destroyFontTexture()
 {
+    txfDestroyTextBatch(textBatch);
     txfUnloadFont(texFont);
 }
 
@@ -274,49 +307,89 @@ void redraw(EventHandler& eventHandler)
     glClear(GL_COLOR_BUFFER_BIT);
 
     // All shaders use position geometry, so enable it here
-    glEnableVertexAttribArray(vertexPositionIndex);
+    glStateEnableVertexAttribArray(vertexPositionIndex);
 
     // Draw a triangle with a colorful shader
-    glUseProgram(triShaderProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
-    glVertexAttribPointer(vertexPositionIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateUseProgram(triShaderProgram);
+    glStateBindBuffer(GL_ARRAY_BUFFER, triangleVbo);
+    glStateVertexAttribPointer(vertexPositionIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
-    // Draw a texture atlas quad with a font texture shader
-    glUseProgram(quadFontShaderProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, quadFontVbo);
-    glVertexAttribPointer(vertexPositionIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    // Draw a texture atlas quad with a font texture shader, bound again after the profile
+    // overlay's font
+    glStateUseProgram(quadFontShaderProgram);
+    if (texFont)
+        txfBindFontTexture(texFont);
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadFontVbo);
+    glStateVertexAttribPointer(vertexPositionIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
     // Draw text string quads with a text shader
-    glEnableVertexAttribArray(vertexTexCoordIndex);
-    glUseProgram(quadsTextShaderProgram);
-    txfRenderString(texFont, "OpenGL", -64.0f * 2.5f, 0.0f);
-    txfRenderString(texFont, "3D", -64.0f, -64.0f * 1.5f);
-    glDisableVertexAttribArray(vertexTexCoordIndex);
+    glStateEnableVertexAttribArray(vertexTexCoordIndex);
+    glStateUseProgram(quadsTextShaderProgram);
+    if (textBatch)
+    {
+        txfBeginTextBatch(textBatch);
+        txfBatchString(textBatch, "OpenGL", -64.0f * 2.5f, 0.0f);
+        txfBatchString(textBatch, "3D", -64.0f, -64.0f * 1.5f);
+        txfFlushTextBatch(textBatch);
+    }
+    glStateDisableVertexAttribArray(vertexTexCoordIndex);
    
     // Done with position geometry
-    glDisableVertexAttribArray(vertexPositionIndex);
+    glStateDisableVertexAttribArray(vertexPositionIndex);
+
+    // Frame time percentiles, with --profile
+    Rect& windowSize = eventHandler.camera().windowSize();
+    profileDrawOverlay(windowSize.width, windowSize.height);
+
+    // Count the state calls the redraw issued and those filtered as redundant
+    glStateEndFrame();
 
     // Swap front/back framebuffers
+    ProfileScope swapScope(PROFILE_SWAP);
     eventHandler.swapWindow();
 }
 
 void mainLoop(void* mainLoopArg) 
 {    
     EventHandler& eventHandler = *((EventHandler*)mainLoopArg);
-    eventHandler.processEvents();
+    profileBeginFrame();
+    {
+        ProfileScope eventsScope(PROFILE_EVENTS);
+        eventHandler.processEvents();
+    }
 
     // Update shader if camera changed
     if (eventHandler.camera().updated())
+    {
+        ProfileScope updateScope(PROFILE_UPDATE);
         updateShader(eventHandler);
+    }
 
-    redraw(eventHandler);
+    // Draw only if something changed, when redrawing on demand
+    if (eventHandler.redrawNeeded())
+    {
+        ProfileScope redrawScope(PROFILE_REDRAW);
+        redraw(eventHandler);
+    }
+    profileEndFrame();
 }
 
 int main(int argc, char** argv)
 {
     EventHandler eventHandler("Hello TXF Text");
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--on-demand") == 0)
+            eventHandler.setRedrawOnDemand(true);
+        else if (strncmp(argv[i], "--profile", 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '='))
+            profileStart("media/rockfont.txf", argv[i][9] == '=' ? argv[i] + 10 : NULL);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            eventHandler.recordEvents(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            eventHandler.replayEvents(argv[++i]);
+    }
 
     // Initialize graphics
     initShaders(eventHandler);
@@ -330,8 +403,12 @@ int main(int argc, char** argv)
     int fps = 0; // Use browser's requestAnimationFrame
     emscripten_set_main_loop_arg(mainLoop, mainLoopArg, fps, true);
 #else
-    while(true) 
-        mainLoop(mainLoopArg);
+    int benchFrames = demoBenchFrames(argc, argv);
+    if (benchFrames > 0)
+        demoBenchRun("hello_text_txf", eventHandler, mainLoop, benchFrames);
+    else
+        while(true) 
+            mainLoop(mainLoopArg);
 #endif
 
     destroyFontTexture();
@@ -5,30 +5,93 @@
 //     Install emscripten: http://kripken.github.io/emscripten-site/docs/getting_started/downloads.html
 //
 // Build on Mac/Linux:
-//     emcc -std=c++11 hello_texture.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS='["png"]' -s FULL_ES2=1 -s WASM=0 --preload-file media/texmap.png -o hello_texture.html
+//     emcc -std=c++11 hello_texture.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp texstream.cpp ktx.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS='["png"]' -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o hello_texture.html
 // Build on Windows:
-//     emcc -std=c++11 hello_texture.cpp events.cpp camera.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS="[""png""]" -s FULL_ES2=1 -s WASM=0 --preload-file media/texmap.png -o hello_texture.html
+//     emcc -std=c++11 hello_texture.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp texture.cpp mipmap.cpp texstream.cpp ktx.cpp -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s SDL2_IMAGE_FORMATS="[""png""]" -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o hello_texture.html
+// 
+//     Only the texture file the GPU samples is downloaded, once the page runs: texmap_bc1.ktx or
+//     texmap_etc1.ktx (175 KB), else texmap.png (748 KB). It is fetched from MEDIA_URL, media/ by
+//     default, relative to the page; build_all builds into the repository root with -DMEDIA_URL=src/media/.
+//
+//     Add -pthread to decode the image on a worker thread; the page must then be served cross origin
+//     isolated for SharedArrayBuffer. Without it the image is decoded on the main thread, one main
+//     loop iteration after the first frame, so that frame is presented with the placeholder.
 // 
 // Run:
 //     emrun hello_texture.html
+//     emrun hello_texture.html [--bilinear] [--on-demand] [--profile[=stats.csv]]
+//     emrun hello_texture.html [--record events.log | --replay events.log]
+//     ./hello_texture --bench [frames]  (native build, see CMakeLists.txt)
+//
+//     The texture is mipmapped and sampled trilinear, --bilinear samples level 0 only.
+//     --on-demand draws frames only when the view or the content changed.
+//     --profile draws frame time percentiles over the frame, and writes them to the file given.
+//     --bench draws frames (default 600) back to back with the camera moving, and prints timings.
+//     --record logs the input events of each frame, --replay processes a log's in place of the window's.
 //
 // Result:
-//     A textured triangle.  Left mouse pans, mouse wheel zooms in/out.  Window is resizable.
+//     A textured triangle, block compressed where the GPU samples BC1 or ETC1 (see img2ktx.cpp), else streamed in from the image, gray until loaded.  Left mouse pans, mouse wheel zooms in/out.  Window is resizable.
 //
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#include <sys/stat.h>
 #endif
 
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_opengles2.h>
 
+#include "demobench.h"
 #include "events.h"
-
-// Texture
+#include "glstate.h"
+#include "ktx.h"
+#include "profile.h"
+#include "shadercache.h"
+#include "texstream.h"
+
+// Block compressed texture, the first of these whose format the GPU samples as is:
+// 128 KB rather than 768 KB of RGB
+struct CompressedTextureFile
+{
+    const char* filename;
+    GLenum format;
+};
+const CompressedTextureFile cCompressedTextureFiles[] =
+{
+    {"media/texmap_bc1.ktx", GL_COMPRESSED_RGB_S3TC_DXT1_EXT},
+    {"media/texmap_etc1.ktx", GL_ETC1_RGB8_OES}
+};
+const int cCompressedTextureCount = sizeof(cCompressedTextureFiles) / sizeof(cCompressedTextureFiles[0]);
+Texture compressedTexture = {};
+
+// Else the image, streamed in over several frames. 256 KB per frame uploads the 512x512
+// RGB texmap.png in 3 frames.
 const char* cTextureFilename = "media/texmap.png";
-GLuint textureObj = 0;
+
+// Trilinear filtering, the texture minified without aliasing when zoomed out
+int textureFlags = TEXTURE_REPEAT | TEXTURE_LINEAR | TEXTURE_MIPMAPS;
+const int cUploadBytesPerFrame = 256 * 1024;
+const unsigned int cPlaceholderColor = 0xff424242;
+TextureStream* textureStream = NULL;
+
+#ifdef __EMSCRIPTEN__
+// Gray until the texture file has been downloaded
+Texture placeholderTexture = {};
+const char* fetchFilename = NULL;
+
+// URL of the media directory relative to the page, see Build
+#ifndef MEDIA_URL
+#define MEDIA_URL media/
+#endif
+#define MEDIA_STRING(url) #url
+#define MEDIA_URL_STRING(url) MEDIA_STRING(url)
+#endif
+
+// Shader program and its geometry
+GLuint shaderProgram = 0;
+GLuint vbo = 0;
+GLint posAttrib = -1;
 
 // Vertex shader
 GLint shaderPan, shaderZoom, shaderAspect;
@@ -61,45 +124,29 @@ void updateShader(EventHandler& eventHandler)
 {
     Camera& camera = eventHandler.camera();
 
+    glStateUseProgram(shaderProgram);
     glUniform2fv(shaderPan, 1, camera.pan());
     glUniform1f(shaderZoom, camera.zoom()); 
     glUniform1f(shaderAspect, camera.aspect());
 }
 
-GLuint initShader(EventHandler& eventHandler)
+void initShader(EventHandler& eventHandler)
 {
-    // Create and compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Create and compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Link vertex and fragment shader into shader program and use it
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glUseProgram(shaderProgram);
+    // Compile & link shaders, or load the program built on an earlier launch
+    shaderProgram = shaderCacheProgram(vertexSource, fragmentSource);
 
     // Get shader variables and initalize them
     shaderPan = glGetUniformLocation(shaderProgram, "pan");
     shaderZoom = glGetUniformLocation(shaderProgram, "zoom");    
     shaderAspect = glGetUniformLocation(shaderProgram, "aspect");
     updateShader(eventHandler);
-
-    return shaderProgram;
 }
 
-void initGeometry(GLuint shaderProgram)
+void initGeometry()
 {
     // Create vertex buffer object and copy vertex data into it
-    GLuint vbo;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, vbo);
     GLfloat triangleVertices[] = 
     {
         0.0f, 0.5f, 0.0f,
@@ -109,59 +156,86 @@ void initGeometry(GLuint shaderProgram)
     glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
 
     // Specify the layout of the shader vertex data (positions only, 3 floats)
-    GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
-    glEnableVertexAttribArray(posAttrib);
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    posAttrib = glGetAttribLocation(shaderProgram, "position");
 }
 
-void initTexture()
+// The KTX file of the first compressed format the GPU samples, else the image
+const char* textureFilename()
 {
-    SDL_Surface *image = IMG_Load(cTextureFilename);
+    for (int i = 0; i < cCompressedTextureCount; ++i)
+        if (ktxFormatSupported(cCompressedTextureFiles[i].format))
+            return cCompressedTextureFiles[i].filename;
+    return cTextureFilename;
+}
+
+// Load the KTX file, or start streaming in the image. False if the KTX file failed to load.
+bool loadTexture(const char* filename)
+{
+    if (filename != cTextureFilename)
+        return ktxLoad(&compressedTexture, filename, textureFlags);
+
+    // Gray placeholder until the image is resident, and for good if it fails to load
+    textureStream = textureStreamCreate(cTextureFilename, textureFlags, cPlaceholderColor);
+    return true;
+}
+
+#ifdef __EMSCRIPTEN__
+void fetchTexture(const char* filename, EventHandler& eventHandler);
 
-    if (!image)
+void onTextureFetched(unsigned handle, void* arg, const char* filename)
+{
+    EventHandler& eventHandler = *((EventHandler*)arg);
+    if (!loadTexture(fetchFilename))
     {
-        // Create a fallback gray texture
-        printf("Failed to load %s, due to %s\n", cTextureFilename, IMG_GetError());
-        const int w = 128, h = 128, bitsPerPixel = 24;
-        image = SDL_CreateRGBSurface(0, w, h, bitsPerPixel, 0, 0, 0, 0);
-        if (image)
-            memset(image->pixels, 0x42, image->w * image->h * bitsPerPixel / 8);
+        fetchTexture(cTextureFilename, eventHandler);
+        return;
     }
+    textureDestroy(&placeholderTexture);
+    eventHandler.requestRedraw();
+}
 
-    if (image)
-    {
-        int bitsPerPixel = image->format->BitsPerPixel;
-        printf ("Image dimensions %dx%d, %d bits per pixel\n", image->w, image->h, bitsPerPixel);
-
-        // Determine GL texture format
-        GLint format = -1;
-        if (bitsPerPixel == 24)
-            format = GL_RGB;
-        else if (bitsPerPixel == 32)
-            format = GL_RGBA;
-
-        if (format != -1)
-        {
-            // Generate a GL texture object
-            glGenTextures(1, &textureObj);
-
-            // Bind GL texture
-            glBindTexture(GL_TEXTURE_2D, textureObj);
-
-            // Set the GL texture's wrapping and stretching properties
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-            // Copy SDL surface image to GL texture
-            glTexImage2D(GL_TEXTURE_2D, 0, format, image->w, image->h, 0,
-                         format, GL_UNSIGNED_BYTE, image->pixels);
-        }
-                                 
-        SDL_FreeSurface (image);        
-    }                       
+void onTextureFetchFailed(unsigned handle, void* arg, int status)
+{
+    printf("ERROR: Downloading %s failed, HTTP status %d\n", fetchFilename, status);
+    if (fetchFilename != cTextureFilename)
+        fetchTexture(cTextureFilename, *((EventHandler*)arg));
+}
+
+// Download filename from the media URL to the same path, then load it
+void fetchTexture(const char* filename, EventHandler& eventHandler)
+{
+    char url[256];
+    snprintf(url, sizeof(url), "%s%s", MEDIA_URL_STRING(MEDIA_URL), strchr(filename, '/') + 1);
+    fetchFilename = filename;
+    emscripten_async_wget2(url, filename, "GET", "", &eventHandler, onTextureFetched, onTextureFetchFailed, NULL);
+}
+#endif
+
+void initTexture(EventHandler& eventHandler)
+{
+    const char* filename = textureFilename();
+#ifdef __EMSCRIPTEN__
+    // Only the file used is downloaded, drawn gray meanwhile
+    const unsigned int placeholderPixels[4] = {cPlaceholderColor, cPlaceholderColor, cPlaceholderColor, cPlaceholderColor};
+    textureCreate(&placeholderTexture, 2, 2, GL_RGBA, textureFlags, placeholderPixels);
+    mkdir("media", 0755);
+    fetchTexture(filename, eventHandler);
+#else
+    if (!loadTexture(filename))
+        loadTexture(cTextureFilename);
+#endif
+}
+
+// The texture to draw with: the compressed texture, the streamed image or a placeholder
+GLuint textureTexobj()
+{
+    if (textureStream)
+        return textureStreamTexobj(textureStream);
+#ifdef __EMSCRIPTEN__
+    if (!compressedTexture.texobj)
+        return placeholderTexture.texobj;
+#endif
+    return compressedTexture.texobj;
 }
 
 void redraw(EventHandler& eventHandler)
@@ -169,33 +243,85 @@ void redraw(EventHandler& eventHandler)
     // Clear screen
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Draw the vertex buffer
+    // Draw the vertex buffer with the placeholder or image texture. Binds the profile
+    // overlay changed are re-issued, others filtered.
+    glStateUseProgram(shaderProgram);
+    glStateBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glStateEnableVertexAttribArray(posAttrib);
+    glStateVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glStateBindTexture(GL_TEXTURE_2D, textureTexobj());
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
+    // Frame time percentiles, with --profile
+    Rect& windowSize = eventHandler.camera().windowSize();
+    profileDrawOverlay(windowSize.width, windowSize.height);
+
+    // Count the state calls the redraw issued and those filtered as redundant
+    glStateEndFrame();
+
     // Swap front/back framebuffers
+    ProfileScope swapScope(PROFILE_SWAP);
     eventHandler.swapWindow();
 }
 
 void mainLoop(void* mainLoopArg) 
 {    
     EventHandler& eventHandler = *((EventHandler*)mainLoopArg);
-    eventHandler.processEvents();
+    profileBeginFrame();
+    {
+        ProfileScope eventsScope(PROFILE_EVENTS);
+        eventHandler.processEvents();
+    }
 
     // Update shader if camera changed
     if (eventHandler.camera().updated())
+    {
+        ProfileScope updateScope(PROFILE_UPDATE);
         updateShader(eventHandler);
+    }
+
+    // Draw only if something changed, when redrawing on demand
+    if (eventHandler.redrawNeeded())
+    {
+        ProfileScope redrawScope(PROFILE_REDRAW);
+        redraw(eventHandler);
+    }
 
-    redraw(eventHandler);
+    // Upload the next rows of the image, if decoded, for the frames to come. Frames are
+    // drawn until it is resident, however it is redrawn.
+    if (textureStream)
+    {
+        bool changed = textureStreamUpdate(textureStream, cUploadBytesPerFrame);
+        int state = SDL_AtomicGet(&textureStream->state);
+        if (changed || (state != TEXTURE_STREAM_RESIDENT && state != TEXTURE_STREAM_FAILED))
+            eventHandler.requestRedraw();
+    }
+    profileEndFrame();
 }
 
 int main(int argc, char** argv)
 {
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], "--bilinear") == 0)
+            textureFlags &= ~TEXTURE_MIPMAPS;
+
     EventHandler eventHandler("Hello Texture");
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--on-demand") == 0)
+            eventHandler.setRedrawOnDemand(true);
+        else if (strncmp(argv[i], "--profile", 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '='))
+            profileStart("media/rockfont.txf", argv[i][9] == '=' ? argv[i] + 10 : NULL);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            eventHandler.recordEvents(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            eventHandler.replayEvents(argv[++i]);
+    }
     
     // Initialize shader, geometry, and texture
-    GLuint shaderProgram = initShader(eventHandler);
-    initGeometry(shaderProgram);
-    initTexture();
+    initShader(eventHandler);
+    initGeometry();
+    initTexture(eventHandler);
 
     // Start the main loop
     void* mainLoopArg = &eventHandler;
@@ -204,11 +330,20 @@ int main(int argc, char** argv)
     int fps = 0; // Use browser's requestAnimationFrame
     emscripten_set_main_loop_arg(mainLoop, mainLoopArg, fps, true);
 #else
-    while(true) 
-        mainLoop(mainLoopArg);
+    int benchFrames = demoBenchFrames(argc, argv);
+    if (benchFrames > 0)
+        demoBenchRun("hello_texture", eventHandler, mainLoop, benchFrames);
+    else
+        while(true) 
+            mainLoop(mainLoopArg);
 #endif
 
-    glDeleteTextures(1, &textureObj);
+    if (textureStream)
+        textureStreamDestroy(textureStream);
+    textureDestroy(&compressedTexture);
+#ifdef __EMSCRIPTEN__
+    textureDestroy(&placeholderTexture);
+#endif
 
     return 0;
 }
\ No newline at end of file
@@ -5,10 +5,18 @@
 //     Install emscripten: http://kripken.github.io/emscripten-site/docs/getting_started/downloads.html
 //
 // Build:
-//     emcc -std=c++11 hello_triangle.cpp events.cpp camera.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 -o hello_triangle.html
+//     emcc -std=c++11 hello_triangle.cpp events.cpp eventlog.cpp camera.cpp glstate.cpp shadercache.cpp profile.cpp texfont.cpp bitexpand.cpp sdf.cpp -s USE_SDL=2 -s FULL_ES2=1 -s WASM=0 --preload-file media/rockfont.txf -o hello_triangle.html
 //
 // Run:
 //     emrun hello_triangle.html
+//     emrun hello_triangle.html [--on-demand] [--profile[=stats.csv]]
+//     emrun hello_triangle.html [--record events.log | --replay events.log]
+//     ./hello_triangle --bench [frames]  (native build, see CMakeLists.txt)
+//
+//     --on-demand draws frames only when the view or the content changed,
+//     --profile draws frame time percentiles over the frame, and writes them to the file given,
+//     --bench draws frames (default 600) back to back with the camera moving, and prints timings,
+//     --record logs the input events of each frame, --replay processes a log's in place of the window's
 //
 // Result:
 //     A colorful triangle.  Left mouse pans, mouse wheel zooms in/out.  Window is resizable.
@@ -21,7 +29,11 @@
 #include <SDL.h>
 #include <SDL_opengles2.h>
 
+#include "demobench.h"
 #include "events.h"
+#include "glstate.h"
+#include "profile.h"
+#include "shadercache.h"
 
 /**
  * https://stackoverflow.com/questions/17537879/in-webgl-what-are-the-differences-between-an-attribute-a-uniform-and-a-varying
@@ -41,6 +53,11 @@
  * See Varying section.
 */
 
+// Shader program and its geometry
+GLuint shaderProgram = 0;
+GLuint vbo = 0;
+GLint posAttrib = -1;
+
 // Vertex shader
 GLint shaderPan, shaderZoom, shaderAspect;
 
@@ -72,45 +89,29 @@ void updateShader(EventHandler& eventHandler)
 {
     Camera& camera = eventHandler.camera();
 
+    glStateUseProgram(shaderProgram);
     glUniform2fv(shaderPan, 1, camera.pan());
     glUniform1f(shaderZoom, camera.zoom()); 
     glUniform1f(shaderAspect, camera.aspect());
 }
 
-GLuint initShader(EventHandler& eventHandler)
+void initShader(EventHandler& eventHandler)
 {
-    // Create and compile vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Create and compile fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Link vertex and fragment shader into shader program and use it
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glUseProgram(shaderProgram);
+    // Compile & link shaders, or load the program built on an earlier launch
+    shaderProgram = shaderCacheProgram(vertexSource, fragmentSource);
 
     // Get shader variables and initialize them
     shaderPan = glGetUniformLocation(shaderProgram, "pan");
     shaderZoom = glGetUniformLocation(shaderProgram, "zoom");    
     shaderAspect = glGetUniformLocation(shaderProgram, "aspect");
     updateShader(eventHandler);
-
-    return shaderProgram;
 }
 
-void initGeometry(GLuint shaderProgram)
+void initGeometry()
 {
     // Create vertex buffer object and copy vertex data into it
-    GLuint vbo;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, vbo);
     GLfloat vertices[] = 
     {
         0.0f, 0.5f, 0.0f,
@@ -120,9 +121,7 @@ void initGeometry(GLuint shaderProgram)
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     // Specify the layout of the shader vertex data (positions only, 3 floats)
-    GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
-    glEnableVertexAttribArray(posAttrib);
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    posAttrib = glGetAttribLocation(shaderProgram, "position");
 }
 
 void redraw(EventHandler& eventHandler)
@@ -130,32 +129,68 @@ void redraw(EventHandler& eventHandler)
     // Clear screen
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Draw the vertex buffer
+    // Draw the vertex buffer. Binds the profile overlay changed are re-issued, others filtered.
+    glStateUseProgram(shaderProgram);
+    glStateBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glStateEnableVertexAttribArray(posAttrib);
+    glStateVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
+    // Frame time percentiles, with --profile
+    Rect& windowSize = eventHandler.camera().windowSize();
+    profileDrawOverlay(windowSize.width, windowSize.height);
+
+    // Count the state calls the redraw issued and those filtered as redundant
+    glStateEndFrame();
+
     // Swap front/back framebuffers
+    ProfileScope swapScope(PROFILE_SWAP);
     eventHandler.swapWindow();
 }
 
 void mainLoop(void* mainLoopArg) 
 {   
     EventHandler& eventHandler = *((EventHandler*)mainLoopArg);
-    eventHandler.processEvents();
+    profileBeginFrame();
+    {
+        ProfileScope eventsScope(PROFILE_EVENTS);
+        eventHandler.processEvents();
+    }
 
     // Update shader if camera changed
     if (eventHandler.camera().updated())
+    {
+        ProfileScope updateScope(PROFILE_UPDATE);
         updateShader(eventHandler);
+    }
 
-    redraw(eventHandler);
+    // Draw only if something changed, when redrawing on demand
+    if (eventHandler.redrawNeeded())
+    {
+        ProfileScope redrawScope(PROFILE_REDRAW);
+        redraw(eventHandler);
+    }
+    profileEndFrame();
 }
 
 int main(int argc, char** argv)
 {
     EventHandler eventHandler("Hello Triangle");
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--on-demand") == 0)
+            eventHandler.setRedrawOnDemand(true);
+        else if (strncmp(argv[i], "--profile", 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '='))
+            profileStart("media/rockfont.txf", argv[i][9] == '=' ? argv[i] + 10 : NULL);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            eventHandler.recordEvents(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            eventHandler.replayEvents(argv[++i]);
+    }
 
     // Initialize shader and geometry
-    GLuint shaderProgram = initShader(eventHandler);
-    initGeometry(shaderProgram);
+    initShader(eventHandler);
+    initGeometry();
 
     // Start the main loop
     void* mainLoopArg = &eventHandler;
@@ -164,8 +199,12 @@ int main(int argc, char** argv)
     int fps = 0; // Use browser's requestAnimationFrame
     emscripten_set_main_loop_arg(mainLoop, mainLoopArg, fps, true);
 #else
-    while(true) 
-        mainLoop(mainLoopArg);
+    int benchFrames = demoBenchFrames(argc, argv);
+    if (benchFrames > 0)
+        demoBenchRun("hello_triangle", eventHandler, mainLoop, benchFrames);
+    else
+        while(true) 
+            mainLoop(mainLoopArg);
 #endif
 
     return 0;
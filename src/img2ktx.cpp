@@ -0,0 +1,330 @@
+//
+// Converts an image (.png etc) to a KTX 1 texture file, block compressed to BC1 (DXT1)
+// or ETC1 for GPUs that sample them directly: 4 bits per texel, 1/6 of RGB
+//
+// Build native:
+//     g++ -std=c++11 -O2 img2ktx.cpp ktx.cpp texture.cpp glstate.cpp mipmap.cpp -I<SDL2 include dir> -lSDL2 -lSDL2_image -lGLESv2 -o img2ktx
+//
+// Run:
+//     ./img2ktx media/texmap.png media/texmap_bc1.ktx bc1 --mipmaps
+//     ./img2ktx media/texmap.png media/texmap_etc1.ktx etc1 --mipmaps
+//
+// Result:
+//     The KTX file, with a full mipmap chain box filtered from the image if --mipmaps,
+//     and the error of its first level against the image as PSNR.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include "ktx.h"
+#include "mipmap.h"
+
+static int squaredError(const int* a, const int* b)
+{
+    return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]);
+}
+
+// A 4x4 block of RGB texels at bx,by, edge texels repeated past the image edges
+static void readBlock(const unsigned char* rgba, int width, int height, int bx, int by, int block[16][3])
+{
+    for (int y = 0; y < 4; ++y)
+        for (int x = 0; x < 4; ++x)
+        {
+            int ix = bx + x < width ? bx + x : width - 1, iy = by + y < height ? by + y : height - 1;
+            for (int i = 0; i < 3; ++i)
+                block[y * 4 + x][i] = rgba[(iy * width + ix) * 4 + i];
+        }
+}
+
+//
+// BC1: endpoints along the principal axis of the block's colors, each texel the
+// nearest of the 4 colors they interpolate
+//
+
+static int toRGB565(const float* color)
+{
+    int r = (int)(color[0] * 31.0f / 255.0f + 0.5f), g = (int)(color[1] * 63.0f / 255.0f + 0.5f),
+        b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+    r = r < 0 ? 0 : (r > 31 ? 31 : r);
+    g = g < 0 ? 0 : (g > 63 ? 63 : g);
+    b = b < 0 ? 0 : (b > 31 ? 31 : b);
+    return (r << 11) | (g << 5) | b;
+}
+
+static void encodeBC1(const int block[16][3], unsigned char* out)
+{
+    float mean[3] = {};
+    for (int t = 0; t < 16; ++t)
+        for (int i = 0; i < 3; ++i)
+            mean[i] += block[t][i] / 16.0f;
+
+    // Principal axis by power iteration on the covariance matrix
+    float cov[3][3] = {};
+    for (int t = 0; t < 16; ++t)
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                cov[i][j] += (block[t][i] - mean[i]) * (block[t][j] - mean[j]);
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[3] = {};
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                next[i] += cov[i][j] * axis[j];
+        float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f)
+            break;
+        for (int i = 0; i < 3; ++i)
+            axis[i] = next[i] / length;
+    }
+
+    float low = 1e9f, high = -1e9f;
+    for (int t = 0; t < 16; ++t)
+    {
+        float projection = 0.0f;
+        for (int i = 0; i < 3; ++i)
+            projection += (block[t][i] - mean[i]) * axis[i];
+        low = projection < low ? projection : low;
+        high = projection > high ? projection : high;
+    }
+    float ends[2][3];
+    for (int i = 0; i < 3; ++i)
+    {
+        ends[0][i] = mean[i] + axis[i] * high;
+        ends[1][i] = mean[i] + axis[i] * low;
+    }
+
+    // 4 color mode needs color0 > color1, equal endpoints use index 0 throughout
+    int c0 = toRGB565(ends[0]), c1 = toRGB565(ends[1]);
+    if (c0 < c1)
+    {
+        int swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+    out[0] = c0 & 0xff; out[1] = c0 >> 8;
+    out[2] = c1 & 0xff; out[3] = c1 >> 8;
+    out[4] = out[5] = out[6] = out[7] = 0;
+
+    // Texel indices against the colors the decoder will produce: texels 0-3 of a block
+    // indexing colors 0-3
+    const unsigned char paletteBlock[8] = {out[0], out[1], out[2], out[3], 0xe4, 0, 0, 0};
+    unsigned char palette[16 * 4];
+    ktxDecode(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, paletteBlock, 4, 4, palette);
+    int colors[4][3];
+    for (int index = 0; index < 4; ++index)
+        for (int i = 0; i < 3; ++i)
+            colors[index][i] = palette[index * 4 + i];
+
+    uint32_t indices = 0;
+    for (int t = 0; t < 16 && c0 != c1; ++t)
+    {
+        int best = 0;
+        for (int index = 1; index < 4; ++index)
+            if (squaredError(block[t], colors[index]) < squaredError(block[t], colors[best]))
+                best = index;
+        indices |= (uint32_t)best << (2 * t);
+    }
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (indices >> (8 * i)) & 0xff;
+}
+
+//
+// ETC1: every flip and individual / differential mode tried, each sub-block its
+// average color with the modifier table that fits it best
+//
+
+static const int cEtcModifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+// Best table for the texels of a sub-block around base, its error, and their indices
+static int fitSubBlock(const int block[16][3], bool flip, int sub, const int* base, int* table, int indices[16])
+{
+    int bestError = 0x7fffffff;
+    for (int candidate = 0; candidate < 8; ++candidate)
+    {
+        int error = 0, candidateIndices[16];
+        for (int t = 0; t < 16; ++t)
+        {
+            int x = t % 4, y = t / 4;
+            if ((flip ? y >= 2 : x >= 2) != (sub == 1))
+                continue;
+            int bestTexelError = 0x7fffffff;
+            for (int index = 0; index < 4; ++index)
+            {
+                int modifier = (index & 2) ? -cEtcModifiers[candidate][index & 1] : cEtcModifiers[candidate][index & 1];
+                int color[3];
+                for (int i = 0; i < 3; ++i)
+                {
+                    int value = base[i] + modifier;
+                    color[i] = value < 0 ? 0 : (value > 255 ? 255 : value);
+                }
+                int texelError = squaredError(block[t], color);
+                if (texelError < bestTexelError)
+                {
+                    bestTexelError = texelError;
+                    candidateIndices[t] = index;
+                }
+            }
+            error += bestTexelError;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            *table = candidate;
+            for (int t = 0; t < 16; ++t)
+                if ((flip ? t / 4 >= 2 : t % 4 >= 2) == (sub == 1))
+                    indices[t] = candidateIndices[t];
+        }
+    }
+    return bestError;
+}
+
+static void encodeETC1(const int block[16][3], unsigned char* out)
+{
+    uint32_t bestHigh = 0, bestLow = 0;
+    long long bestError = -1;
+    for (int flip = 0; flip < 2; ++flip)
+    {
+        int average[2][3] = {};
+        for (int t = 0; t < 16; ++t)
+            for (int i = 0; i < 3; ++i)
+                average[(flip ? t / 4 >= 2 : t % 4 >= 2)][i] += block[t][i];
+
+        for (int differential = 0; differential < 2; ++differential)
+        {
+            // Quantize the averages, 4 bits each or 5 bits and a 3 bit difference
+            int quantized[2][3], base[2][3];
+            bool fits = true;
+            for (int sub = 0; sub < 2; ++sub)
+                for (int i = 0; i < 3; ++i)
+                {
+                    float mean = average[sub][i] / 8.0f;
+                    if (differential)
+                    {
+                        quantized[sub][i] = (int)(mean * 31.0f / 255.0f + 0.5f);
+                        base[sub][i] = (quantized[sub][i] << 3) | (quantized[sub][i] >> 2);
+                    }
+                    else
+                    {
+                        quantized[sub][i] = (int)(mean * 15.0f / 255.0f + 0.5f);
+                        base[sub][i] = (quantized[sub][i] << 4) | quantized[sub][i];
+                    }
+                }
+            for (int i = 0; i < 3 && differential; ++i)
+                fits = fits && quantized[1][i] - quantized[0][i] >= -4 && quantized[1][i] - quantized[0][i] <= 3;
+            if (!fits)
+                continue;
+
+            int tables[2], indices[16];
+            long long error = fitSubBlock(block, flip != 0, 0, base[0], &tables[0], indices)
+                              + fitSubBlock(block, flip != 0, 1, base[1], &tables[1], indices);
+            if (bestError >= 0 && error >= bestError)
+                continue;
+
+            bestError = error;
+            bestHigh = (tables[0] << 5) | (tables[1] << 2) | (differential << 1) | flip;
+            for (int i = 0; i < 3; ++i)
+            {
+                if (differential)
+                    bestHigh |= (quantized[0][i] << (27 - 8 * i)) | (((quantized[1][i] - quantized[0][i]) & 7) << (24 - 8 * i));
+                else
+                    bestHigh |= (quantized[0][i] << (28 - 8 * i)) | (quantized[1][i] << (24 - 8 * i));
+            }
+            bestLow = 0;
+            for (int t = 0; t < 16; ++t)
+            {
+                int k = (t % 4) * 4 + t / 4;
+                bestLow |= ((uint32_t)(indices[t] & 1) << k) | ((uint32_t)(indices[t] >> 1) << (k + 16));
+            }
+        }
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = (bestHigh >> (24 - 8 * i)) & 0xff;
+        out[4 + i] = (bestLow >> (24 - 8 * i)) & 0xff;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4 || (strcmp(argv[3], "bc1") != 0 && strcmp(argv[3], "etc1") != 0))
+    {
+        printf("usage: %s input.png output.ktx bc1|etc1 [--mipmaps]\n", argv[0]);
+        return 1;
+    }
+    bool bc1 = strcmp(argv[3], "bc1") == 0;
+    GLenum format = bc1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_ETC1_RGB8_OES;
+
+    SDL_Surface* loaded = IMG_Load(argv[1]);
+    SDL_Surface* image = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ABGR8888, 0) : NULL;
+    if (!image)
+    {
+        printf("%s: %s\n", argv[1], IMG_GetError());
+        return 1;
+    }
+    int width = image->w, height = image->h;
+    std::vector<unsigned char> rgba(width * height * 4);
+    for (int row = 0; row < height; ++row)
+        memcpy(&rgba[row * width * 4], (const unsigned char*)image->pixels + row * image->pitch, width * 4);
+    SDL_FreeSurface(image);
+    SDL_FreeSurface(loaded);
+
+    // Each level filtered from the uncompressed level above, then compressed
+    bool mipmaps = argc > 4 && strcmp(argv[4], "--mipmaps") == 0;
+    int levels = mipmaps ? mipmapLevels(width, height) : 1;
+    std::vector<std::vector<unsigned char> > levelBlocks(levels);
+    std::vector<unsigned char> level = rgba, nextLevel;
+    int levelWidth = width, levelHeight = height, bytes = 0;
+    for (int i = 0; i < levels; ++i)
+    {
+        levelBlocks[i].resize(ktxImageBytes(format, levelWidth, levelHeight));
+        unsigned char* out = &levelBlocks[i][0];
+        int block[16][3];
+        for (int by = 0; by < levelHeight; by += 4)
+            for (int bx = 0; bx < levelWidth; bx += 4, out += 8)
+            {
+                readBlock(&level[0], levelWidth, levelHeight, bx, by, block);
+                if (bc1)
+                    encodeBC1(block, out);
+                else
+                    encodeETC1(block, out);
+            }
+        bytes += (int)levelBlocks[i].size();
+
+        if (i + 1 < levels)
+        {
+            nextLevel.resize((levelWidth > 1 ? levelWidth / 2 : 1) * (levelHeight > 1 ? levelHeight / 2 : 1) * 4);
+            mipmapDownsample(&level[0], levelWidth, levelHeight, 4, &nextLevel[0]);
+            level.swap(nextLevel);
+            levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+            levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+        }
+    }
+
+    std::vector<const unsigned char*> images(levels);
+    for (int i = 0; i < levels; ++i)
+        images[i] = &levelBlocks[i][0];
+    if (!ktxWrite(argv[2], format, width, height, levels, &images[0]))
+    {
+        printf("%s: write failed\n", argv[2]);
+        return 1;
+    }
+
+    // Error of what the GPU will show, RGB only
+    std::vector<unsigned char> decoded(width * height * 4);
+    ktxDecode(format, images[0], width, height, &decoded[0]);
+    double squared = 0.0;
+    for (int i = 0; i < width * height * 4; ++i)
+        if (i % 4 != 3)
+            squared += (decoded[i] - rgba[i]) * (decoded[i] - rgba[i]);
+    double mse = squared / (width * height * 3);
+    printf("%s: %dx%d %s, %d levels, %d KB (%d KB as RGB), PSNR %.1f dB\n", argv[2], width, height, ktxFormatName(format),
+           levels, bytes / 1024, width * height * 3 / 1024 * (mipmaps ? 4 : 3) / 3,
+           mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0);
+    return 0;
+}
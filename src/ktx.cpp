@@ -0,0 +1,646 @@
+//
+// KTX 1 texture files, GPU compressed formats and their CPU decoders
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "ktx.h"
+#include "mipmap.h"
+
+static const unsigned char cKtxIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const uint32_t cKtxEndianness = 0x04030201;
+
+// File header after the identifier, 13 uint32s
+enum {
+    KTX_ENDIANNESS, KTX_GL_TYPE, KTX_GL_TYPE_SIZE, KTX_GL_FORMAT, KTX_GL_INTERNAL_FORMAT,
+    KTX_GL_BASE_INTERNAL_FORMAT, KTX_PIXEL_WIDTH, KTX_PIXEL_HEIGHT, KTX_PIXEL_DEPTH,
+    KTX_ARRAY_ELEMENTS, KTX_FACES, KTX_MIPMAP_LEVELS, KTX_KEY_VALUE_BYTES, KTX_HEADER_WORDS
+};
+
+static const int cKtxHeaderBytes = 12 + KTX_HEADER_WORDS * 4;
+
+// Largest width or height read or written. Image bytes stay within 32 bits, so within
+// size_t on wasm32, and texel offsets within int.
+static const int cKtxMaxSize = 16384;
+
+const char* ktxFormatName(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return "BC1";
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return "BC1 RGBA";
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "BC3";
+        case GL_ETC1_RGB8_OES: return "ETC1";
+        case GL_COMPRESSED_RGB8_ETC2: return "ETC2 RGB";
+        case GL_COMPRESSED_RGBA8_ETC2_EAC: return "ETC2 RGBA";
+        case GL_COMPRESSED_RGBA_ASTC_4x4_KHR: return "ASTC 4x4";
+        case GL_RGB: return "RGB";
+        case GL_RGBA: return "RGBA";
+        default: return "unknown";
+    }
+}
+
+// Bytes per 4x4 block, 0 if not a block compressed format
+static int blockBytes(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_ETC1_RGB8_OES:
+        case GL_COMPRESSED_RGB8_ETC2:
+            return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+size_t ktxImageBytes(GLenum internalFormat, int width, int height)
+{
+    if (internalFormat == GL_RGB || internalFormat == GL_RGBA)
+        return (size_t)((uint64_t)width * height * (internalFormat == GL_RGB ? 3 : 4));
+    return (size_t)((uint64_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(internalFormat));
+}
+
+// Whether the extensions string lists one of names. Browsers list WebGL extension
+// names both bare and prefixed with GL_.
+static bool hasExtension(const char* const* names)
+{
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (!extensions)
+        return false;
+    for (; *names; ++names)
+    {
+        size_t length = strlen(*names);
+        for (const char* found = strstr(extensions, *names); found; found = strstr(found + 1, *names))
+            if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+                return true;
+    }
+    return false;
+}
+
+static bool etc2Supported()
+{
+    // Core in OpenGL ES 3, but not in WebGL 2
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version && strncmp(version, "OpenGL ES ", 10) == 0 && version[10] >= '3' && !strstr(version, "WebGL"))
+        return true;
+    static const char* const cNames[] = {"WEBGL_compressed_texture_etc", "GL_ARB_ES3_compatibility", NULL};
+    return hasExtension(cNames);
+}
+
+bool ktxFormatSupported(GLenum internalFormat)
+{
+    static const char* const cS3tc[] = {"GL_EXT_texture_compression_s3tc", "WEBGL_compressed_texture_s3tc", NULL};
+    static const char* const cDxt1[] = {"GL_EXT_texture_compression_dxt1", NULL};
+    static const char* const cDxt5[] = {"GL_ANGLE_texture_compression_dxt5", "GL_CHROMIUM_texture_compression_dxt5", NULL};
+    static const char* const cEtc1[] = {"GL_OES_compressed_ETC1_RGB8_texture", "WEBGL_compressed_texture_etc1", NULL};
+    static const char* const cAstc[] = {"GL_KHR_texture_compression_astc_ldr", "WEBGL_compressed_texture_astc", NULL};
+    switch (internalFormat)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            return hasExtension(cS3tc) || hasExtension(cDxt1);
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            return hasExtension(cS3tc) || hasExtension(cDxt5);
+        case GL_ETC1_RGB8_OES:
+            return hasExtension(cEtc1) || etc2Supported();
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+            return etc2Supported();
+        case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:
+            return hasExtension(cAstc);
+        case GL_RGB:
+        case GL_RGBA:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ktxFormatDecodable(GLenum internalFormat)
+{
+    return blockBytes(internalFormat) != 0 && internalFormat != GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+}
+
+//
+// Block decoders: each writes a 4x4 block of RGBA texels, texel x,y at (y * 4 + x) * 4
+//
+
+static unsigned char clamp255(int value)
+{
+    return (unsigned char)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+static void setTexel(unsigned char* texel, int r, int g, int b, int a)
+{
+    texel[0] = clamp255(r);
+    texel[1] = clamp255(g);
+    texel[2] = clamp255(b);
+    texel[3] = clamp255(a);
+}
+
+static uint32_t readBigEndian32(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+// BC1 colors, 4 color mode always for BC3 color blocks
+static void decodeBC1(const unsigned char* block, unsigned char* texels, bool fourColors, bool alpha)
+{
+    int c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+    int r[4], g[4], b[4], a[4] = {255, 255, 255, 255};
+    int endpoints[2] = {c0, c1};
+    for (int i = 0; i < 2; ++i)
+    {
+        int r5 = (endpoints[i] >> 11) & 31, g6 = (endpoints[i] >> 5) & 63, b5 = endpoints[i] & 31;
+        r[i] = (r5 << 3) | (r5 >> 2);
+        g[i] = (g6 << 2) | (g6 >> 4);
+        b[i] = (b5 << 3) | (b5 >> 2);
+    }
+    if (fourColors || c0 > c1)
+    {
+        r[2] = (2 * r[0] + r[1]) / 3; g[2] = (2 * g[0] + g[1]) / 3; b[2] = (2 * b[0] + b[1]) / 3;
+        r[3] = (r[0] + 2 * r[1]) / 3; g[3] = (g[0] + 2 * g[1]) / 3; b[3] = (b[0] + 2 * b[1]) / 3;
+    }
+    else
+    {
+        r[2] = (r[0] + r[1]) / 2; g[2] = (g[0] + g[1]) / 2; b[2] = (b[0] + b[1]) / 2;
+        r[3] = g[3] = b[3] = 0;
+        a[3] = alpha ? 0 : 255;
+    }
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+    for (int i = 0; i < 16; ++i)
+    {
+        int index = (indices >> (2 * i)) & 3;
+        setTexel(texels + i * 4, r[index], g[index], b[index], a[index]);
+    }
+}
+
+// BC3: BC4 style alpha block, then a BC1 color block
+static void decodeBC3(const unsigned char* block, unsigned char* texels)
+{
+    decodeBC1(block + 8, texels, true, false);
+
+    int alphas[8] = {block[0], block[1]};
+    if (alphas[0] > alphas[1])
+    {
+        for (int i = 1; i < 7; ++i)
+            alphas[i + 1] = ((7 - i) * alphas[0] + i * alphas[1]) / 7;
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+            alphas[i + 1] = ((5 - i) * alphas[0] + i * alphas[1]) / 5;
+        alphas[6] = 0;
+        alphas[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+        indices |= (uint64_t)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; ++i)
+        texels[i * 4 + 3] = (unsigned char)alphas[(indices >> (3 * i)) & 7];
+}
+
+static const int cEtcModifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+static const int cEtcDistances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+static int extend4(int value) { return (value << 4) | value; }
+static int extend5(int value) { return (value << 3) | (value >> 2); }
+static int extend6(int value) { return (value << 2) | (value >> 4); }
+static int extend7(int value) { return (value << 1) | (value >> 6); }
+
+// ETC2 T and H modes: 4 paint colors indexed directly by the texel indices
+static void decodeEtcPaint(uint32_t indices, const int paint[4][3], unsigned char* texels)
+{
+    for (int x = 0; x < 4; ++x)
+        for (int y = 0; y < 4; ++y)
+        {
+            int k = x * 4 + y, index = (((indices >> (k + 16)) & 1) << 1) | ((indices >> k) & 1);
+            setTexel(texels + (y * 4 + x) * 4, paint[index][0], paint[index][1], paint[index][2], 255);
+        }
+}
+
+static void decodeEtcT(uint32_t high, uint32_t indices, unsigned char* texels)
+{
+    int c1[3] = {extend4((((high >> 27) & 3) << 2) | ((high >> 24) & 3)), extend4((high >> 20) & 15), extend4((high >> 16) & 15)};
+    int c2[3] = {extend4((high >> 12) & 15), extend4((high >> 8) & 15), extend4((high >> 4) & 15)};
+    int distance = cEtcDistances[(((high >> 2) & 3) << 1) | (high & 1)];
+    int paint[4][3];
+    for (int i = 0; i < 3; ++i)
+    {
+        paint[0][i] = c1[i];
+        paint[1][i] = clamp255(c2[i] + distance);
+        paint[2][i] = c2[i];
+        paint[3][i] = clamp255(c2[i] - distance);
+    }
+    decodeEtcPaint(indices, paint, texels);
+}
+
+static void decodeEtcH(uint32_t high, uint32_t indices, unsigned char* texels)
+{
+    int r1 = (high >> 27) & 15, g1 = (((high >> 24) & 7) << 1) | ((high >> 20) & 1),
+        b1 = (((high >> 19) & 1) << 3) | ((high >> 15) & 7);
+    int r2 = (high >> 11) & 15, g2 = (high >> 7) & 15, b2 = (high >> 3) & 15;
+    int order = ((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2);
+    int distance = cEtcDistances[(((high >> 2) & 1) << 2) | ((high & 1) << 1) | order];
+    int c1[3] = {extend4(r1), extend4(g1), extend4(b1)}, c2[3] = {extend4(r2), extend4(g2), extend4(b2)};
+    int paint[4][3];
+    for (int i = 0; i < 3; ++i)
+    {
+        paint[0][i] = clamp255(c1[i] + distance);
+        paint[1][i] = clamp255(c1[i] - distance);
+        paint[2][i] = clamp255(c2[i] + distance);
+        paint[3][i] = clamp255(c2[i] - distance);
+    }
+    decodeEtcPaint(indices, paint, texels);
+}
+
+// ETC2 planar mode: colors at the origin, right (H) and bottom (V) corners, interpolated
+static void decodeEtcPlanar(uint64_t bits, unsigned char* texels)
+{
+    int o[3] = {extend6((int)(bits >> 57) & 63),
+                extend7((int)((((bits >> 56) & 1) << 6) | ((bits >> 49) & 63))),
+                extend6((int)((((bits >> 48) & 1) << 5) | (((bits >> 43) & 3) << 3) | ((bits >> 39) & 7)))};
+    int h[3] = {extend6((int)((((bits >> 34) & 31) << 1) | ((bits >> 32) & 1))),
+                extend7((int)(bits >> 25) & 127),
+                extend6((int)(bits >> 19) & 63)};
+    int v[3] = {extend6((int)(bits >> 13) & 63), extend7((int)(bits >> 6) & 127), extend6((int)bits & 63)};
+    for (int y = 0; y < 4; ++y)
+        for (int x = 0; x < 4; ++x)
+        {
+            int c[3];
+            for (int i = 0; i < 3; ++i)
+                c[i] = (x * (h[i] - o[i]) + y * (v[i] - o[i]) + 4 * o[i] + 2) >> 2;
+            setTexel(texels + (y * 4 + x) * 4, c[0], c[1], c[2], 255);
+        }
+}
+
+// ETC1, or ETC2 RGB where differential mode base colors overflowing select T, H or planar mode
+static void decodeEtc(const unsigned char* block, unsigned char* texels, bool etc2)
+{
+    uint32_t high = readBigEndian32(block), indices = readBigEndian32(block + 4);
+    int base[2][3];
+    if ((high & 2) == 0)
+    {
+        // Individual mode: two 4 bit colors
+        for (int i = 0; i < 3; ++i)
+        {
+            base[0][i] = extend4((high >> (28 - 8 * i)) & 15);
+            base[1][i] = extend4((high >> (24 - 8 * i)) & 15);
+        }
+    }
+    else
+    {
+        // Differential mode: a 5 bit color and a 3 bit signed difference
+        int first[3], second[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            int delta = (high >> (24 - 8 * i)) & 7;
+            first[i] = (high >> (27 - 8 * i)) & 31;
+            second[i] = first[i] + (delta >= 4 ? delta - 8 : delta);
+        }
+        if (etc2 && (second[0] < 0 || second[0] > 31))
+        {
+            decodeEtcT(high, indices, texels);
+            return;
+        }
+        if (etc2 && (second[1] < 0 || second[1] > 31))
+        {
+            decodeEtcH(high, indices, texels);
+            return;
+        }
+        if (etc2 && (second[2] < 0 || second[2] > 31))
+        {
+            decodeEtcPlanar(((uint64_t)high << 32) | indices, texels);
+            return;
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            base[0][i] = extend5(first[i]);
+            base[1][i] = extend5(second[i] & 31);
+        }
+    }
+
+    // Sub-blocks are 2x4 side by side, or 4x2 one above the other when flipped
+    bool flip = (high & 1) != 0;
+    int tables[2] = {(int)(high >> 5) & 7, (int)(high >> 2) & 7};
+    for (int x = 0; x < 4; ++x)
+        for (int y = 0; y < 4; ++y)
+        {
+            int sub = flip ? y >= 2 : x >= 2, k = x * 4 + y;
+            int magnitude = cEtcModifiers[tables[sub]][(indices >> k) & 1];
+            int modifier = ((indices >> (k + 16)) & 1) ? -magnitude : magnitude;
+            setTexel(texels + (y * 4 + x) * 4, base[sub][0] + modifier, base[sub][1] + modifier,
+                     base[sub][2] + modifier, 255);
+        }
+}
+
+static const int cEacModifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12}, {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12}, {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10}, {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9}, {-2, -4, -8, -10, 1, 3, 7, 9}, {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9}, {-1, -2, -3, -10, 0, 1, 2, 9}, {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+// ETC2 RGBA: EAC alpha block, then an ETC2 RGB block
+static void decodeEtc2Rgba(const unsigned char* block, unsigned char* texels)
+{
+    decodeEtc(block + 8, texels, true);
+
+    uint64_t bits = ((uint64_t)readBigEndian32(block) << 32) | readBigEndian32(block + 4);
+    int base = (int)(bits >> 56), multiplier = (int)(bits >> 52) & 15;
+    const int* modifiers = cEacModifiers[(bits >> 48) & 15];
+    for (int x = 0; x < 4; ++x)
+        for (int y = 0; y < 4; ++y)
+        {
+            int index = (int)(bits >> (45 - 3 * (x * 4 + y))) & 7;
+            texels[(y * 4 + x) * 4 + 3] = clamp255(base + modifiers[index] * multiplier);
+        }
+}
+
+bool ktxDecode(GLenum internalFormat, const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+    if (!ktxFormatDecodable(internalFormat))
+        return false;
+
+    int bytes = blockBytes(internalFormat);
+    unsigned char texels[4 * 4 * 4];
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4, blocks += bytes)
+        {
+            switch (internalFormat)
+            {
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: decodeBC1(blocks, texels, false, false); break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: decodeBC1(blocks, texels, false, true); break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: decodeBC3(blocks, texels); break;
+                case GL_ETC1_RGB8_OES: decodeEtc(blocks, texels, false); break;
+                case GL_COMPRESSED_RGB8_ETC2: decodeEtc(blocks, texels, true); break;
+                default: decodeEtc2Rgba(blocks, texels); break;
+            }
+
+            // Blocks overhanging the image edges are clipped
+            int columns = width - bx < 4 ? width - bx : 4, rows = height - by < 4 ? height - by : 4;
+            for (int y = 0; y < rows; ++y)
+                memcpy(rgba + ((by + y) * width + bx) * 4, texels + y * 16, columns * 4);
+        }
+    }
+    return true;
+}
+
+//
+// Files
+//
+
+static uint32_t swapBytes(uint32_t value)
+{
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+// Parse the header of a KTX file's first bytes, returning whether words need byte swapping
+static bool parseHeader(const unsigned char* data, int size, KtxHeader* header, uint32_t* keyValueBytes, bool* swap)
+{
+    if (size < cKtxHeaderBytes || memcmp(data, cKtxIdentifier, sizeof(cKtxIdentifier)) != 0)
+        return false;
+
+    uint32_t words[KTX_HEADER_WORDS];
+    memcpy(words, data + sizeof(cKtxIdentifier), sizeof(words));
+    *swap = words[KTX_ENDIANNESS] != cKtxEndianness;
+    if (*swap)
+    {
+        if (swapBytes(words[KTX_ENDIANNESS]) != cKtxEndianness)
+            return false;
+        for (int i = 0; i < KTX_HEADER_WORDS; ++i)
+            words[i] = swapBytes(words[i]);
+    }
+
+    // 2D, single image textures only, of a size whose bytes can't overflow
+    if (words[KTX_PIXEL_DEPTH] > 1 || words[KTX_ARRAY_ELEMENTS] > 0 || words[KTX_FACES] != 1
+        || words[KTX_PIXEL_WIDTH] == 0 || words[KTX_PIXEL_HEIGHT] == 0
+        || words[KTX_PIXEL_WIDTH] > (uint32_t)cKtxMaxSize || words[KTX_PIXEL_HEIGHT] > (uint32_t)cKtxMaxSize)
+        return false;
+
+    header->gl_type = words[KTX_GL_TYPE];
+    header->gl_format = words[KTX_GL_FORMAT];
+    header->internal_format = words[KTX_GL_INTERNAL_FORMAT];
+    header->width = (int)words[KTX_PIXEL_WIDTH];
+    header->height = (int)words[KTX_PIXEL_HEIGHT];
+    header->levels = words[KTX_MIPMAP_LEVELS] > 0 ? (int)words[KTX_MIPMAP_LEVELS] : 1;
+    *keyValueBytes = words[KTX_KEY_VALUE_BYTES];
+
+    // Uncompressed images only as unsigned byte RGB / RGBA
+    if (header->gl_type != 0)
+    {
+        if (header->gl_type != GL_UNSIGNED_BYTE || (header->gl_format != GL_RGB && header->gl_format != GL_RGBA))
+            return false;
+        header->internal_format = header->gl_format;
+    }
+    return ktxImageBytes(header->internal_format, 1, 1) != 0;
+}
+
+bool ktxReadHeader(const char* filename, KtxHeader* header)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+        return false;
+    unsigned char data[cKtxHeaderBytes];
+    int size = (int)fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    uint32_t keyValueBytes;
+    bool swap;
+    return parseHeader(data, size, header, &keyValueBytes, &swap);
+}
+
+// Compressed levels straight to the GPU
+static bool uploadCompressed(Texture* texture, const KtxHeader* header, GLenum uploadFormat,
+                             const std::vector<const unsigned char*>& images, int flags)
+{
+    // Mipmapped only with the full chain, ES 2 has no GL_TEXTURE_MAX_LEVEL
+    int fullLevels = mipmapLevels(header->width, header->height);
+    bool mipmaps = (flags & (TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS)) != 0 && header->levels >= fullLevels;
+    if ((flags & (TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS)) && !mipmaps)
+        printf("INFO: %d of %d mipmap levels, texture not mipmapped\n", header->levels, fullLevels);
+
+    texture->format = uploadFormat;
+    texture->flags = mipmaps ? flags : flags & ~(TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS);
+    texture->image_width = texture->width = header->width;
+    texture->image_height = texture->height = header->height;
+    texture->levels = mipmaps ? fullLevels : 1;
+    texture->bytes = texture->bytes_saved = 0;
+
+    glGenTextures(1, &texture->texobj);
+    textureSetSampler(texture, texture->flags);
+
+    int width = header->width, height = header->height;
+    for (int level = 0; level < texture->levels; ++level)
+    {
+        size_t bytes = ktxImageBytes(header->internal_format, width, height);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, uploadFormat, width, height, 0, (GLsizei)bytes, images[level]);
+        texture->bytes += (int)bytes;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    GLenum glError = glGetError();
+    if (glError != GL_NO_ERROR)
+    {
+        printf("ERROR: Texture %d (%dx%d %s) not built, error code %d\n", texture->texobj, header->width, header->height,
+               ktxFormatName(uploadFormat), glError);
+        textureDestroy(texture);
+        return false;
+    }
+    printf("OK: Texture %d (%dx%d %s, %d levels) built, %d KB, %d KB as RGBA\n", texture->texobj, header->width,
+           header->height, ktxFormatName(uploadFormat), texture->levels, texture->bytes / 1024,
+           (int)(ktxImageBytes(GL_RGBA, header->width, header->height) * (mipmaps ? 4 : 3) / 3 / 1024));
+    return true;
+}
+
+bool ktxLoad(Texture* texture, const char* filename, int flags)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+    {
+        printf("ERROR: Failed to open %s\n", filename);
+        return false;
+    }
+    std::vector<unsigned char> data;
+    unsigned char buffer[64 * 1024];
+    for (size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+        data.insert(data.end(), buffer, buffer + read);
+    fclose(file);
+
+    KtxHeader header;
+    uint32_t keyValueBytes;
+    bool swap;
+    if (!parseHeader(data.empty() ? NULL : &data[0], (int)data.size(), &header, &keyValueBytes, &swap))
+    {
+        printf("ERROR: %s is not a supported KTX file\n", filename);
+        return false;
+    }
+
+    // Levels: 4 byte image size, then the image padded to 4 bytes. Sizes are compared
+    // with the bytes left, as offsets near 4 GB would wrap size_t on wasm32.
+    std::vector<const unsigned char*> images;
+    size_t offset = keyValueBytes <= data.size() - cKtxHeaderBytes ? cKtxHeaderBytes + keyValueBytes : data.size();
+    int width = header.width, height = header.height;
+    for (int level = 0; level < header.levels; ++level)
+    {
+        if (data.size() - offset < 4)
+            break;
+        uint32_t imageSize;
+        memcpy(&imageSize, &data[offset], 4);
+        imageSize = swap ? swapBytes(imageSize) : imageSize;
+        offset += 4;
+
+        // Uncompressed rows are 4 byte aligned, as GL_UNPACK_ALIGNMENT 4 expects
+        size_t rowBytes = ktxImageBytes(header.internal_format, width, 1);
+        size_t expected = header.gl_type ? ((rowBytes + 3) & ~(size_t)3) * height
+                                         : ktxImageBytes(header.internal_format, width, height);
+        if (imageSize < expected || expected > data.size() - offset)
+            break;
+        images.push_back(&data[offset]);
+        uint64_t paddedSize = ((uint64_t)imageSize + 3) & ~(uint64_t)3;
+        offset = paddedSize < data.size() - offset ? offset + (size_t)paddedSize : data.size();
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    if (images.empty())
+    {
+        printf("ERROR: %s is truncated\n", filename);
+        return false;
+    }
+    header.levels = (int)images.size();
+
+    // Upload compressed blocks as they are where the GPU samples them, ETC1 as ETC2 where
+    // it has ETC2 only. NPOT textures the context can't repeat or mipmap are decoded.
+    GLenum format = header.internal_format;
+    bool npotOk = ((header.width & (header.width - 1)) == 0 && (header.height & (header.height - 1)) == 0)
+                  || textureNPOTAllowed(flags);
+    if (header.gl_type == 0 && ktxFormatSupported(format) && npotOk)
+    {
+        static const char* const cEtc1[] = {"GL_OES_compressed_ETC1_RGB8_texture", "WEBGL_compressed_texture_etc1", NULL};
+        GLenum uploadFormat = format == GL_ETC1_RGB8_OES && !hasExtension(cEtc1) ? GL_COMPRESSED_RGB8_ETC2 : format;
+        return uploadCompressed(texture, &header, uploadFormat, images, flags);
+    }
+
+    // Otherwise level 0 as RGB / RGBA, decoded when compressed
+    std::vector<unsigned char> pixels;
+    GLenum pixelFormat = GL_RGBA;
+    if (header.gl_type == 0)
+    {
+        if (!ktxFormatDecodable(format))
+        {
+            printf("ERROR: %s is %s, which this context doesn't support\n", filename, ktxFormatName(format));
+            return false;
+        }
+        pixels.resize(ktxImageBytes(GL_RGBA, header.width, header.height));
+        ktxDecode(format, images[0], header.width, header.height, &pixels[0]);
+        printf("INFO: %s decoded from %s on the CPU\n", filename, ktxFormatName(format));
+    }
+    else
+    {
+        pixelFormat = format;
+        size_t rowBytes = ktxImageBytes(format, header.width, 1), paddedRowBytes = (rowBytes + 3) & ~(size_t)3;
+        pixels.resize(rowBytes * header.height);
+        for (int row = 0; row < header.height; ++row)
+            memcpy(&pixels[row * rowBytes], images[0] + row * paddedRowBytes, rowBytes);
+    }
+    return textureCreate(texture, header.width, header.height, pixelFormat, flags, &pixels[0]);
+}
+
+bool ktxWrite(const char* filename, GLenum internalFormat, int width, int height, int levels,
+              const unsigned char* const* images)
+{
+    bool compressed = internalFormat != GL_RGB && internalFormat != GL_RGBA;
+    if (ktxImageBytes(internalFormat, 1, 1) == 0 || levels < 1 || width < 1 || height < 1
+        || width > cKtxMaxSize || height > cKtxMaxSize)
+        return false;
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    uint32_t words[KTX_HEADER_WORDS] = {};
+    words[KTX_ENDIANNESS] = cKtxEndianness;
+    words[KTX_GL_TYPE] = compressed ? 0 : GL_UNSIGNED_BYTE;
+    words[KTX_GL_TYPE_SIZE] = 1;
+    words[KTX_GL_FORMAT] = compressed ? 0 : internalFormat;
+    words[KTX_GL_INTERNAL_FORMAT] = internalFormat;
+    words[KTX_GL_BASE_INTERNAL_FORMAT] = internalFormat == GL_RGB || internalFormat == GL_ETC1_RGB8_OES
+                                         || internalFormat == GL_COMPRESSED_RGB8_ETC2
+                                         || internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? GL_RGB : GL_RGBA;
+    words[KTX_PIXEL_WIDTH] = width;
+    words[KTX_PIXEL_HEIGHT] = height;
+    words[KTX_FACES] = 1;
+    words[KTX_MIPMAP_LEVELS] = levels;
+    bool written = fwrite(cKtxIdentifier, sizeof(cKtxIdentifier), 1, file) == 1
+                   && fwrite(words, sizeof(words), 1, file) == 1;
+
+    // Uncompressed rows padded to 4 bytes
+    static const unsigned char cPadding[4] = {};
+    for (int level = 0; level < levels && written; ++level)
+    {
+        size_t rowBytes = ktxImageBytes(internalFormat, width, 1), paddedRowBytes = (rowBytes + 3) & ~(size_t)3;
+        uint32_t imageSize = (uint32_t)(compressed ? ktxImageBytes(internalFormat, width, height) : paddedRowBytes * height);
+        written = fwrite(&imageSize, 4, 1, file) == 1;
+        if (compressed)
+            written = written && fwrite(images[level], imageSize, 1, file) == 1;
+        for (int row = 0; row < height && !compressed && written; ++row)
+            written = fwrite(images[level] + row * rowBytes, 1, rowBytes, file) == rowBytes
+                      && fwrite(cPadding, 1, paddedRowBytes - rowBytes, file) == paddedRowBytes - rowBytes;
+        size_t levelPadding = (4 - imageSize % 4) % 4;
+        written = written && fwrite(cPadding, 1, levelPadding, file) == levelPadding;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,93 @@
+//
+// KTX 1 texture files holding GPU compressed (or plain RGB/RGBA) images. Compressed
+// blocks are uploaded as they are when the context samples the format, else decoded
+// to RGBA on the CPU: BC1 (DXT1), BC3 (DXT5), ETC1 and ETC2 RGB / RGBA have decoders,
+// ASTC is upload only.
+//
+// https://registry.khronos.org/KTX/specs/1.0/ktxspec.v1.html
+//
+#pragma once
+#include <stddef.h>
+#include <SDL_opengles2.h>
+
+#include "texture.h"
+
+// Compressed formats, ES 3 and extension enums not in every gl2ext.h
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#endif
+
+typedef struct {
+    GLenum gl_type;             // 0 for compressed images
+    GLenum gl_format;           // 0 for compressed images
+    GLenum internal_format;     // GL_COMPRESSED_* etc, or GL_RGB / GL_RGBA
+    int width;
+    int height;
+    int levels;                 // Mipmap levels in the file, at least 1
+} KtxHeader;
+
+extern const char* ktxFormatName(
+    GLenum internalFormat);
+
+// Bytes of a width x height image of internalFormat, 0 if not a known format
+extern size_t ktxImageBytes(
+    GLenum internalFormat,
+    int width, int height);
+
+// Whether the current context samples internalFormat, queried from the GL version
+// and extensions. ETC1 images load as ETC2 where only ETC2 is supported.
+extern bool ktxFormatSupported(
+    GLenum internalFormat);
+
+// Whether ktxDecode has a CPU decoder for internalFormat
+extern bool ktxFormatDecodable(
+    GLenum internalFormat);
+
+// Decode a width x height image of internalFormat blocks to tightly packed RGBA rows
+extern bool ktxDecode(
+    GLenum internalFormat,
+    const unsigned char* blocks,
+    int width, int height,
+    unsigned char* rgba);
+
+// Read the header of filename only. Returns false if it is not a usable 2D KTX file.
+extern bool ktxReadHeader(
+    const char* filename,
+    KtxHeader* header);
+
+// Load filename into texture, bound on return. The file's mipmap levels are used when
+// flags ask for mipmaps and it has a full chain; images decoded on the CPU get theirs
+// from textureCreate.
+// texture->format is the internal format uploaded, texture->bytes its size in GPU memory.
+// Returns false (and prints why) on failure.
+extern bool ktxLoad(
+    Texture* texture,
+    const char* filename,
+    int flags);
+
+// Write a KTX 1 file of levels images of internalFormat, level 0 width x height and each
+// following level half the size. Returns false on failure.
+extern bool ktxWrite(
+    const char* filename,
+    GLenum internalFormat,
+    int width, int height,
+    int levels,
+    const unsigned char* const* images);
@@ -0,0 +1,206 @@
+//
+// Mipmap chains built on the CPU
+//
+#if defined(__SSE2__) || defined(_M_X64)
+#define MIPMAP_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIPMAP_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(__wasm_simd128__)
+#define MIPMAP_HAVE_SIMD128 1
+#include <wasm_simd128.h>
+#endif
+#include "mipmap.h"
+
+// Filter dst texels [first, dstWidth) of a row from source rows row0 and row1
+static void downsampleRowTail(const unsigned char* row0, const unsigned char* row1, unsigned char* dst,
+                              int srcWidth, int dstWidth, int components, int first)
+{
+    for (int x = first; x < dstWidth; ++x)
+    {
+        int x0 = 2 * x, x1 = 2 * x + 1 < srcWidth ? 2 * x + 1 : x0;
+        for (int c = 0; c < components; ++c)
+        {
+            int sum = row0[x0 * components + c] + row0[x1 * components + c]
+                      + row1[x0 * components + c] + row1[x1 * components + c];
+            dst[x * components + c] = (unsigned char)((sum + 2) >> 2);
+        }
+    }
+}
+
+static void downsampleRowScalar(const unsigned char* row0, const unsigned char* row1, unsigned char* dst,
+                                int srcWidth, int dstWidth, int components)
+{
+    downsampleRowTail(row0, row1, dst, srcWidth, dstWidth, components, 0);
+}
+
+#ifdef MIPMAP_HAVE_SSE2
+// 16 source bytes of each row to 8 destination bytes: vertical sums in 16 bits, then
+// adjacent texels added, 1 byte texels with a multiply-add, 4 byte texels with a shift
+static void downsampleRowSSE2(const unsigned char* row0, const unsigned char* row1, unsigned char* dst,
+                              int srcWidth, int dstWidth, int components)
+{
+    const __m128i zero = _mm_setzero_si128(), ones = _mm_set1_epi16(1), two = _mm_set1_epi16(2);
+    int x = 0;
+    if (components == 1 || components == 4)
+    {
+        int step = 8 / components;
+        for (; (x + step) * 2 <= srcWidth && x + step <= dstWidth; x += step)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 2 * components));
+            __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 2 * components));
+            __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            __m128i sums;
+            if (components == 1)
+                sums = _mm_packs_epi32(_mm_madd_epi16(low, ones), _mm_madd_epi16(high, ones));
+            else
+                sums = _mm_unpacklo_epi64(_mm_add_epi16(low, _mm_srli_si128(low, 8)),
+                                          _mm_add_epi16(high, _mm_srli_si128(high, 8)));
+            __m128i texels = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+            _mm_storel_epi64((__m128i*)(dst + x * components), _mm_packus_epi16(texels, texels));
+        }
+    }
+    downsampleRowTail(row0, row1, dst, srcWidth, dstWidth, components, x);
+}
+#endif
+
+#ifdef MIPMAP_HAVE_NEON
+// 16 source texels of each row to 8: pairwise widening adds, then a rounding narrow.
+// 4 byte texels are deinterleaved into a vector per component.
+static void downsampleRowNEON(const unsigned char* row0, const unsigned char* row1, unsigned char* dst,
+                              int srcWidth, int dstWidth, int components)
+{
+    int x = 0;
+    if (components == 1)
+    {
+        for (; x * 2 + 16 <= srcWidth && x + 8 <= dstWidth; x += 8)
+        {
+            uint16x8_t sums = vaddq_u16(vpaddlq_u8(vld1q_u8(row0 + x * 2)), vpaddlq_u8(vld1q_u8(row1 + x * 2)));
+            vst1_u8(dst + x, vrshrn_n_u16(sums, 2));
+        }
+    }
+    else if (components == 4)
+    {
+        for (; x * 2 + 16 <= srcWidth && x + 8 <= dstWidth; x += 8)
+        {
+            uint8x16x4_t a = vld4q_u8(row0 + x * 8), b = vld4q_u8(row1 + x * 8);
+            uint8x8x4_t texels;
+            for (int c = 0; c < 4; ++c)
+                texels.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[c]), vpaddlq_u8(b.val[c])), 2);
+            vst4_u8(dst + x * 4, texels);
+        }
+    }
+    downsampleRowTail(row0, row1, dst, srcWidth, dstWidth, components, x);
+}
+#endif
+
+#ifdef MIPMAP_HAVE_SIMD128
+// As SSE2: 16 source bytes of each row to 8 destination bytes
+static void downsampleRowSIMD128(const unsigned char* row0, const unsigned char* row1, unsigned char* dst,
+                                 int srcWidth, int dstWidth, int components)
+{
+    const v128_t two = wasm_i16x8_splat(2);
+    int x = 0;
+    if (components == 1 || components == 4)
+    {
+        int step = 8 / components;
+        for (; (x + step) * 2 <= srcWidth && x + step <= dstWidth; x += step)
+        {
+            v128_t a = wasm_v128_load(row0 + x * 2 * components), b = wasm_v128_load(row1 + x * 2 * components);
+            v128_t sums;
+            if (components == 1)
+                sums = wasm_i16x8_add(wasm_u16x8_extadd_pairwise_u8x16(a), wasm_u16x8_extadd_pairwise_u8x16(b));
+            else
+            {
+                v128_t low = wasm_i16x8_add(wasm_u16x8_extend_low_u8x16(a), wasm_u16x8_extend_low_u8x16(b));
+                v128_t high = wasm_i16x8_add(wasm_u16x8_extend_high_u8x16(a), wasm_u16x8_extend_high_u8x16(b));
+                sums = wasm_i16x8_add(wasm_i64x2_shuffle(low, high, 0, 2), wasm_i64x2_shuffle(low, high, 1, 3));
+            }
+            v128_t texels = wasm_u16x8_shr(wasm_i16x8_add(sums, two), 2);
+            wasm_v128_store64_lane(dst + x * components, wasm_u8x16_narrow_i16x8(texels, texels), 0);
+        }
+    }
+    downsampleRowTail(row0, row1, dst, srcWidth, dstWidth, components, x);
+}
+#endif
+
+bool mipmapBackendAvailable(MipmapBackend backend)
+{
+    switch (backend)
+    {
+        case MIPMAP_SCALAR: return true;
+        #ifdef MIPMAP_HAVE_SSE2
+        case MIPMAP_SSE2: return true;
+        #endif
+        #ifdef MIPMAP_HAVE_NEON
+        case MIPMAP_NEON: return true;
+        #endif
+        #ifdef MIPMAP_HAVE_SIMD128
+        case MIPMAP_SIMD128: return true;
+        #endif
+        default: return false;
+    }
+}
+
+const char* mipmapBackendName(MipmapBackend backend)
+{
+    switch (backend)
+    {
+        case MIPMAP_SCALAR: return "scalar";
+        case MIPMAP_SSE2: return "sse2";
+        case MIPMAP_NEON: return "neon";
+        case MIPMAP_SIMD128: return "simd128";
+        default: return "unknown";
+    }
+}
+
+MipmapBackend mipmapBestBackend()
+{
+    for (int backend = MIPMAP_BACKENDS - 1; backend > MIPMAP_SCALAR; --backend)
+        if (mipmapBackendAvailable((MipmapBackend)backend))
+            return (MipmapBackend)backend;
+    return MIPMAP_SCALAR;
+}
+
+int mipmapLevels(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ++levels;
+    }
+    return levels;
+}
+
+void mipmapDownsample(const unsigned char* src, int width, int height, int components, unsigned char* dst,
+                      MipmapBackend backend)
+{
+    void (*downsampleRow)(const unsigned char*, const unsigned char*, unsigned char*, int, int, int) = downsampleRowScalar;
+    switch (backend)
+    {
+        #ifdef MIPMAP_HAVE_SSE2
+        case MIPMAP_SSE2: downsampleRow = downsampleRowSSE2; break;
+        #endif
+        #ifdef MIPMAP_HAVE_NEON
+        case MIPMAP_NEON: downsampleRow = downsampleRowNEON; break;
+        #endif
+        #ifdef MIPMAP_HAVE_SIMD128
+        case MIPMAP_SIMD128: downsampleRow = downsampleRowSIMD128; break;
+        #endif
+        default: break;
+    }
+
+    int dstWidth = width > 1 ? width / 2 : 1, dstHeight = height > 1 ? height / 2 : 1;
+    for (int y = 0; y < dstHeight; ++y)
+    {
+        int y0 = 2 * y, y1 = 2 * y + 1 < height ? 2 * y + 1 : y0;
+        downsampleRow(src + y0 * width * components, src + y1 * width * components, dst + y * dstWidth * components,
+                      width, dstWidth, components);
+    }
+}
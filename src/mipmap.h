@@ -0,0 +1,29 @@
+//
+// Mipmap chains built on the CPU: each level a 2x2 box filter of the level above,
+// rounded to nearest. Used by textures created with TEXTURE_CPU_MIPMAPS and by img2ktx.
+//
+#pragma once
+
+enum MipmapBackend {MIPMAP_SCALAR, MIPMAP_SSE2, MIPMAP_NEON, MIPMAP_SIMD128, MIPMAP_BACKENDS};
+
+// Backends are chosen at compile time (-msse2, NEON, -msimd128), scalar is always available.
+// SIMD backends filter 1 and 4 byte texels, 2 and 3 byte texels are always scalar.
+extern bool mipmapBackendAvailable(MipmapBackend backend);
+
+extern const char* mipmapBackendName(MipmapBackend backend);
+
+extern MipmapBackend mipmapBestBackend();
+
+// Levels of a full chain down to 1x1, level 0 included
+extern int mipmapLevels(
+    int width, int height);
+
+// Filter a width x height image of components bytes per texel, rows tightly packed, into
+// the next level: half the size rounded down, at least 1. Odd last rows and columns
+// are dropped, a single row or column is filtered with itself.
+extern void mipmapDownsample(
+    const unsigned char* src,
+    int width, int height,
+    int components,
+    unsigned char* dst,
+    MipmapBackend backend = mipmapBestBackend());
@@ -0,0 +1,415 @@
+//
+// Frame profiling shared by the samples
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <SDL.h>
+#include "glstate.h"
+#include "shadercache.h"
+#include "texfont.h"
+#include "profile.h"
+
+// GL_EXT_disjoint_timer_query enums and entry points
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_RESULT_EXT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE_EXT
+#define GL_QUERY_RESULT_AVAILABLE_EXT 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+typedef void (GL_APIENTRYP GenQueriesProc)(GLsizei n, GLuint* ids);
+typedef void (GL_APIENTRYP BeginQueryProc)(GLenum target, GLuint id);
+typedef void (GL_APIENTRYP EndQueryProc)(GLenum target);
+typedef void (GL_APIENTRYP GetQueryObjectuivProc)(GLuint id, GLenum pname, GLuint* params);
+typedef void (GL_APIENTRYP GetQueryObjectui64vProc)(GLuint id, GLenum pname, unsigned long long* params);
+
+// Queries in flight: results arrive frames after the commands they time were issued
+#define PROFILE_GPU_QUERIES 4
+
+// Frames between overlay text updates, so the numbers can be read
+#define PROFILE_OVERLAY_FRAMES 30
+
+static const char* const cTimerNames[PROFILE_TIMERS] = {"frame", "events", "update", "redraw", "swap", "gpu"};
+
+typedef struct {
+    float ms[PROFILE_HISTORY];  // Ring of the last samples
+    int next;
+    int samples;
+    Uint64 start;               // Performance counter at profileBegin, 0 if not running
+} TimerHistory;
+
+static bool enabled = false;
+static TimerHistory timers[PROFILE_TIMERS];
+static Uint64 lastFrameStart = 0;
+static int frames = 0;
+static const char* dumpFilename = NULL;
+
+// GPU timer queries, NULL entry points where the context has none
+static GenQueriesProc genQueries = NULL;
+static BeginQueryProc beginQuery = NULL;
+static EndQueryProc endQuery = NULL;
+static GetQueryObjectuivProc getQueryObjectuiv = NULL;
+static GetQueryObjectui64vProc getQueryObjectui64v = NULL;
+static GLuint gpuQueries[PROFILE_GPU_QUERIES];
+static int gpuIssued = 0, gpuCollected = 0;     // Queries ended and read, gpuQueries used round robin
+static bool gpuQueryActive = false;
+
+// Overlay font, text shader and the lines drawn
+static TexFont* overlayFont = NULL;
+static TxfTextBatch* overlayBatch = NULL;
+static GLuint overlayProgram = 0;
+static GLint overlayViewport, overlayShift, overlayColor;
+static char overlayLines[PROFILE_TIMERS + 1][4][16];    // Heading and a row per timer, in columns
+static int overlayLineCount = 0;
+
+static const char* const cOverlayAttribNames[] = {"position", "texCoord", "offset", NULL};
+
+// Text in window pixels, origin bottom left, shifted by a pixel for the shadow pass
+static const GLchar* overlayVertexSource =
+    "uniform vec2 viewport;                                     \n"
+    "uniform vec2 shift;                                        \n"
+    "attribute vec4 position;                                   \n"
+    "attribute vec2 texCoord;                                   \n"
+    "attribute vec2 offset;                                     \n"
+    "varying vec2 vTexCoord;                                    \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    vec2 pixel = position.xy + offset + shift;             \n"
+    "    gl_Position = vec4(pixel * 2.0 / viewport - 1.0,       \n"
+    "                       0.0, 1.0);                          \n"
+    "    vTexCoord = texCoord;                                  \n"
+    "}                                                          \n";
+
+static const GLchar* overlayFragmentSource =
+    "precision mediump float;                                   \n"
+    "uniform sampler2D texSampler;                              \n"
+    "uniform vec3 color;                                        \n"
+    "varying vec2 vTexCoord;                                    \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    float alpha = texture2D(texSampler, vTexCoord).a;      \n"
+    "    gl_FragColor = vec4(color, alpha);                     \n"
+    "}                                                          \n";
+
+static void queryGpuTimers()
+{
+    // WebGL 2 contexts expose EXT_disjoint_timer_query_webgl2 instead, with core entry points
+    if (!SDL_GL_ExtensionSupported("GL_EXT_disjoint_timer_query"))
+    {
+        printf("INFO: GPU timer queries not supported\n");
+        return;
+    }
+    genQueries = (GenQueriesProc)SDL_GL_GetProcAddress("glGenQueriesEXT");
+    beginQuery = (BeginQueryProc)SDL_GL_GetProcAddress("glBeginQueryEXT");
+    endQuery = (EndQueryProc)SDL_GL_GetProcAddress("glEndQueryEXT");
+    getQueryObjectuiv = (GetQueryObjectuivProc)SDL_GL_GetProcAddress("glGetQueryObjectuivEXT");
+    getQueryObjectui64v = (GetQueryObjectui64vProc)SDL_GL_GetProcAddress("glGetQueryObjectui64vEXT");
+    if (!genQueries || !beginQuery || !endQuery || !getQueryObjectuiv || !getQueryObjectui64v)
+    {
+        beginQuery = NULL;
+        printf("INFO: GPU timer query entry points missing\n");
+        return;
+    }
+    genQueries(PROFILE_GPU_QUERIES, gpuQueries);
+}
+
+static void loadOverlay(const char* fontName)
+{
+    overlayFont = txfLoadFont(fontName);
+    if (!overlayFont)
+    {
+        printf("ERROR: Profile overlay font %s: %s\n", fontName, txfErrorString());
+        return;
+    }
+
+    // Glyphs are drawn texel to pixel
+    txfEstablishTexture(overlayFont, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    overlayBatch = txfCreateTextBatch(overlayFont);
+
+    overlayProgram = shaderCacheProgram(overlayVertexSource, overlayFragmentSource, cOverlayAttribNames);
+    overlayViewport = glGetUniformLocation(overlayProgram, "viewport");
+    overlayShift = glGetUniformLocation(overlayProgram, "shift");
+    overlayColor = glGetUniformLocation(overlayProgram, "color");
+}
+
+void profileStart(const char* fontName, const char* dumpFile)
+{
+    if (enabled)
+        return;
+    enabled = true;
+    dumpFilename = dumpFile;
+    queryGpuTimers();
+    if (fontName)
+        loadOverlay(fontName);
+    printf("INFO: Profiling%s%s%s\n", overlayFont ? " with overlay" : "", dumpFilename ? ", stats to " : "",
+           dumpFilename ? dumpFilename : "");
+}
+
+bool profileEnabled()
+{
+    return enabled;
+}
+
+static void addSample(ProfileTimer timer, float ms)
+{
+    TimerHistory& history = timers[timer];
+    history.ms[history.next] = ms;
+    history.next = (history.next + 1) % PROFILE_HISTORY;
+    if (history.samples < PROFILE_HISTORY)
+        ++history.samples;
+}
+
+static float elapsedMs(Uint64 start, Uint64 end)
+{
+    return (float)((end - start) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
+static void beginGpuQuery()
+{
+    if (!beginQuery || gpuQueryActive || gpuIssued - gpuCollected == PROFILE_GPU_QUERIES)
+        return;
+    beginQuery(GL_TIME_ELAPSED_EXT, gpuQueries[gpuIssued % PROFILE_GPU_QUERIES]);
+    gpuQueryActive = true;
+}
+
+static void endGpuQuery()
+{
+    if (!gpuQueryActive)
+        return;
+    endQuery(GL_TIME_ELAPSED_EXT);
+    gpuQueryActive = false;
+    ++gpuIssued;
+}
+
+// Read the results of the queries that completed, in the order they were issued
+static void collectGpuQueries()
+{
+    if (gpuCollected == gpuIssued)
+        return;
+
+    // Results spanning a disjoint event (a GPU clock change, a context loss) are meaningless.
+    // Reading the flag clears it, so it covers every query completed since the last read.
+    GLint disjoint = GL_FALSE;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    while (gpuCollected < gpuIssued)
+    {
+        GLuint query = gpuQueries[gpuCollected % PROFILE_GPU_QUERIES];
+        GLuint available = GL_FALSE;
+        getQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available)
+            break;
+        unsigned long long ns = 0;
+        getQueryObjectui64v(query, GL_QUERY_RESULT_EXT, &ns);
+        if (!disjoint)
+            addSample(PROFILE_GPU, (float)(ns / 1e6));
+        ++gpuCollected;
+    }
+}
+
+void profileBegin(ProfileTimer timer)
+{
+    if (!enabled)
+        return;
+    timers[timer].start = SDL_GetPerformanceCounter();
+
+    // The GPU time of the redraw is of the commands before the swap
+    if (timer == PROFILE_REDRAW)
+        beginGpuQuery();
+    else if (timer == PROFILE_SWAP)
+        endGpuQuery();
+}
+
+void profileEnd(ProfileTimer timer)
+{
+    if (!enabled || !timers[timer].start)
+        return;
+    Uint64 end = SDL_GetPerformanceCounter();
+    addSample(timer, elapsedMs(timers[timer].start, end));
+    timers[timer].start = 0;
+
+    // A redraw that did not swap
+    if (timer == PROFILE_REDRAW)
+        endGpuQuery();
+}
+
+void profileBeginFrame()
+{
+    if (!enabled)
+        return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (lastFrameStart)
+        addSample(PROFILE_FRAME, elapsedMs(lastFrameStart, now));
+    lastFrameStart = now;
+}
+
+const char* profileTimerName(ProfileTimer timer)
+{
+    return timer >= 0 && timer < PROFILE_TIMERS ? cTimerNames[timer] : "unknown";
+}
+
+// Nearest rank percentile of sorted samples
+static float percentile(const float* sorted, int samples, int percent)
+{
+    int rank = (samples * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+ProfileStats profileStats(ProfileTimer timer)
+{
+    ProfileStats stats = {0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    const TimerHistory& history = timers[timer];
+    if (history.samples == 0)
+        return stats;
+
+    float sorted[PROFILE_HISTORY];
+    memcpy(sorted, history.ms, history.samples * sizeof(float));
+    std::sort(sorted, sorted + history.samples);
+    double sum = 0.0;
+    for (int i = 0; i < history.samples; ++i)
+        sum += sorted[i];
+
+    stats.samples = history.samples;
+    stats.mean_ms = (float)(sum / history.samples);
+    stats.p50_ms = percentile(sorted, history.samples, 50);
+    stats.p95_ms = percentile(sorted, history.samples, 95);
+    stats.p99_ms = percentile(sorted, history.samples, 99);
+    stats.max_ms = sorted[history.samples - 1];
+    return stats;
+}
+
+static void updateOverlayText()
+{
+    static const char* const cHeadings[4] = {"ms", "p50", "p95", "p99"};
+    overlayLineCount = 0;
+    for (int column = 0; column < 4; ++column)
+        snprintf(overlayLines[0][column], sizeof(overlayLines[0][column]), "%s", cHeadings[column]);
+    ++overlayLineCount;
+
+    for (int timer = 0; timer < PROFILE_TIMERS; ++timer)
+    {
+        ProfileStats stats = profileStats((ProfileTimer)timer);
+        if (stats.samples == 0)
+            continue;
+        char (*line)[16] = overlayLines[overlayLineCount++];
+        snprintf(line[0], sizeof(line[0]), "%s", cTimerNames[timer]);
+        snprintf(line[1], sizeof(line[1]), "%.2f", stats.p50_ms);
+        snprintf(line[2], sizeof(line[2]), "%.2f", stats.p95_ms);
+        snprintf(line[3], sizeof(line[3]), "%.2f", stats.p99_ms);
+    }
+}
+
+void profileEndFrame()
+{
+    if (!enabled)
+        return;
+    collectGpuQueries();
+
+    ++frames;
+    if (overlayFont && (frames % PROFILE_OVERLAY_FRAMES == 0 || overlayLineCount == 0))
+        updateOverlayText();
+    if (dumpFilename && frames % PROFILE_HISTORY == 0)
+        profileDump(dumpFilename);
+}
+
+// Add the overlay lines to the batch, names left aligned and numbers right aligned in columns
+static void batchOverlayText(int windowHeight)
+{
+    const float margin = 8.0f, nameWidth = 72.0f, columnWidth = 64.0f;
+    const float lineHeight = (float)(overlayFont->max_ascent + overlayFont->max_descent);
+    for (int line = 0; line < overlayLineCount; ++line)
+    {
+        float y = windowHeight - margin - overlayFont->max_ascent - line * lineHeight;
+        txfBatchString(overlayBatch, overlayLines[line][0], margin, y);
+        for (int column = 1; column < 4; ++column)
+        {
+            const char* text = overlayLines[line][column];
+            float right = margin + nameWidth + column * columnWidth;
+            txfBatchString(overlayBatch, text, right - txfGetStringWidth(overlayFont, text, (int)strlen(text)), y);
+        }
+    }
+}
+
+void profileDrawOverlay(int windowWidth, int windowHeight)
+{
+    if (!enabled || !overlayBatch || !overlayProgram || overlayLineCount == 0)
+        return;
+
+    glStateUseProgram(overlayProgram);
+    GLfloat viewport[2] = {(GLfloat)windowWidth, (GLfloat)windowHeight};
+    glUniform2fv(overlayViewport, 1, viewport);
+    glStateActiveTexture(GL_TEXTURE0);
+    txfBindFontTexture(overlayFont);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glStateEnable(GL_BLEND);
+    glStateBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glStateEnableVertexAttribArray(TXF_ATTRIB_POSITION);
+    glStateEnableVertexAttribArray(TXF_ATTRIB_TEXCOORD);
+
+    // A dark shadow a pixel down and right keeps the text readable over any frame
+    const GLfloat shadowShift[2] = {1.0f, -1.0f}, noShift[2] = {0.0f, 0.0f};
+    const GLfloat shadowColor[3] = {0.0f, 0.0f, 0.0f}, textColor[3] = {1.0f, 1.0f, 0.4f};
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        glUniform2fv(overlayShift, 1, pass == 0 ? shadowShift : noShift);
+        glUniform3fv(overlayColor, 1, pass == 0 ? shadowColor : textColor);
+        txfBeginTextBatch(overlayBatch);
+        batchOverlayText(windowHeight);
+        txfFlushTextBatch(overlayBatch);
+    }
+
+    glStateDisableVertexAttribArray(TXF_ATTRIB_TEXCOORD);
+    if (!blend)
+        glStateDisable(GL_BLEND);
+}
+
+bool profileDump(const char* filename)
+{
+    size_t length = strlen(filename);
+    bool json = length >= 5 && strcmp(filename + length - 5, ".json") == 0;
+    bool toStdout = strcmp(filename, "-") == 0;
+    FILE* file = toStdout ? stdout : fopen(filename, "w");
+    if (!file)
+    {
+        printf("ERROR: Failed to write profile stats %s\n", filename);
+        return false;
+    }
+
+    if (json)
+        fprintf(file, "{\n  \"frames\": %d,\n  \"timers\": {", frames);
+    else
+        fprintf(file, "timer,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+    for (int timer = 0; timer < PROFILE_TIMERS; ++timer)
+    {
+        ProfileStats stats = profileStats((ProfileTimer)timer);
+        if (json)
+            fprintf(file, "%s\n    \"%s\": {\"samples\": %d, \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p95_ms\": %.3f, "
+                    "\"p99_ms\": %.3f, \"max_ms\": %.3f}", timer ? "," : "", cTimerNames[timer], stats.samples,
+                    stats.mean_ms, stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms);
+        else
+            fprintf(file, "%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", cTimerNames[timer], stats.samples, stats.mean_ms,
+                    stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms);
+    }
+    if (json)
+        fprintf(file, "\n  }\n}\n");
+
+    if (toStdout)
+        return true;
+    if (fclose(file) != 0)
+    {
+        printf("ERROR: Failed to write profile stats %s\n", filename);
+        return false;
+    }
+    return true;
+}
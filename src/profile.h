@@ -0,0 +1,64 @@
+//
+// Frame profiling: CPU timers around the parts of each frame, the GPU time of the redraw
+// where EXT_disjoint_timer_query is available, percentiles over the last frames, drawn
+// over the frame with texfont and dumped as CSV or JSON to compare runs.
+//
+#pragma once
+
+// Frame is the time between frame starts, vsync and idle waits included. Redraw includes
+// the swap. GPU is the GPU time of the commands from the redraw's start to the swap.
+enum ProfileTimer {PROFILE_FRAME, PROFILE_EVENTS, PROFILE_UPDATE, PROFILE_REDRAW, PROFILE_SWAP, PROFILE_GPU,
+                   PROFILE_TIMERS};
+
+// Samples kept per timer, the percentiles are of these
+#define PROFILE_HISTORY 240
+
+typedef struct {
+    int samples;                // Up to PROFILE_HISTORY
+    float mean_ms;
+    float p50_ms;
+    float p95_ms;
+    float p99_ms;
+    float max_ms;
+} ProfileStats;
+
+// Start profiling, with the GL context current. Timers do nothing until then.
+// fontName, if not NULL, is the .txf font profileDrawOverlay draws the stats with.
+// dumpFilename, if not NULL, is rewritten with the stats every PROFILE_HISTORY frames.
+extern void profileStart(
+    const char* fontName,
+    const char* dumpFilename);
+
+extern bool profileEnabled();
+
+// Call at the start and end of each main loop iteration
+extern void profileBeginFrame();
+extern void profileEndFrame();
+
+extern void profileBegin(ProfileTimer timer);
+extern void profileEnd(ProfileTimer timer);
+
+// Times its scope
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileTimer timer) : mTimer(timer) { profileBegin(timer); }
+    ~ProfileScope() { profileEnd(mTimer); }
+
+private:
+    ProfileTimer mTimer;
+};
+
+extern const char* profileTimerName(ProfileTimer timer);
+
+extern ProfileStats profileStats(ProfileTimer timer);
+
+// Draw the stats in the top left corner of the window, if started with a font. Binds
+// its own program, buffers and texture, and leaves the texture coordinate array disabled.
+extern void profileDrawOverlay(
+    int windowWidth, int windowHeight);
+
+// Write the stats of every timer, as JSON if filename ends in .json, else as CSV.
+// "-" writes to stdout. Returns false on failure.
+extern bool profileDump(
+    const char* filename);
@@ -0,0 +1,94 @@
+//
+// Signed distance fields from coverage images
+//
+// Exact euclidean distance transform, separable into 1D transforms of columns then
+// rows: Felzenszwalb & Huttenlocher, "Distance Transforms of Sampled Functions".
+//
+#include <math.h>
+#include <vector>
+#include "sdf.h"
+
+static const float cSdfInfinity = 1e20f;
+
+// 1D squared distance transform of f (n samples, stride apart) in place, using the
+// lower envelope of parabolas rooted at each sample. v, z and d are scratch space.
+static void
+sdfTransform1D(float* f, int n, int stride, int* v, float* z, float* d)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -cSdfInfinity;
+    z[1] = cSdfInfinity;
+    for (int q = 1; q < n; ++q)
+    {
+        // Drop parabolas hidden by the one rooted at q
+        float fq = f[q * stride] + q * q;
+        float s = (fq - (f[v[k] * stride] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        while (s <= z[k])
+        {
+            --k;
+            s = (fq - (f[v[k] * stride] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = cSdfInfinity;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q)
+    {
+        while (z[k + 1] < q)
+            ++k;
+        int p = v[k];
+        d[q] = (q - p) * (q - p) + f[p * stride];
+    }
+    for (int q = 0; q < n; ++q)
+        f[q * stride] = d[q];
+}
+
+// Squared distance from every texel to the nearest texel where inside(texel) is true
+static void
+sdfSquaredDistances(const unsigned char* src, int srcStride, int width, int height, bool inside,
+                    std::vector<float>& grid)
+{
+    grid.resize(width * height);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            grid[y * width + x] = ((src[y * srcStride + x] >= 128) == inside) ? 0.0f : cSdfInfinity;
+
+    int n = width > height ? width : height;
+    std::vector<int> v(n);
+    std::vector<float> z(n + 1), d(n);
+    for (int x = 0; x < width; ++x)
+        sdfTransform1D(&grid[x], height, width, &v[0], &z[0], &d[0]);
+    for (int y = 0; y < height; ++y)
+        sdfTransform1D(&grid[y * width], width, 1, &v[0], &z[0], &d[0]);
+}
+
+void
+sdfGenerate(const unsigned char* src, int srcStride, unsigned char* dst, int dstStride,
+            int width, int height, int spread)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    // Distance to the nearest inside texel (0 inside) and to the nearest outside texel (0 outside)
+    std::vector<float> toInside, toOutside;
+    sdfSquaredDistances(src, srcStride, width, height, true, toInside);
+    sdfSquaredDistances(src, srcStride, width, height, false, toOutside);
+
+    // The edge lies half way between an inside and an outside texel center
+    const float scale = 127.0f / (spread > 0 ? spread : 1);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            int i = y * width + x;
+            float distance = toInside[i] > 0.0f ? 0.5f - sqrtf(toInside[i]) : sqrtf(toOutside[i]) - 0.5f;
+            float value = 128.0f + distance * scale;
+            value = value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+            dst[y * dstStride + x] = (unsigned char)(value + 0.5f);
+        }
+    }
+}
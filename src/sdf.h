@@ -0,0 +1,16 @@
+//
+// Signed distance fields from coverage images, for text that stays sharp when
+// magnified. Texels >= 128 are inside. Each output texel is the signed distance
+// from its center to the nearest edge, 128 on the edge, increasing inside, and
+// reaching 0 / 255 at spread texels outside / inside.
+//
+#pragma once
+
+// Distance transform of width x height texels of src rows of srcStride bytes
+// into dst rows of dstStride bytes, in time linear in the texel count.
+// src and dst may be the same image.
+extern void sdfGenerate(
+    const unsigned char* src, int srcStride,
+    unsigned char* dst, int dstStride,
+    int width, int height,
+    int spread);
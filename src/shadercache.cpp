@@ -0,0 +1,283 @@
+//
+// Shader programs shared by the samples
+//
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "shadercache.h"
+
+// OpenGL ES 3 and GL_OES_get_program_binary enums, the same values in both
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+
+typedef void (GL_APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (GL_APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLint length);
+typedef void (GL_APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+typedef struct {
+    GLenum type;
+    unsigned long long hash;
+    std::string source;
+    GLuint shader;
+} CachedShader;
+
+typedef struct {
+    unsigned long long hash;
+    std::string inputs;         // Sources and attribute names, each NUL terminated
+    GLuint program;
+} CachedProgram;
+
+static std::vector<CachedShader> cachedShaders;
+static std::vector<CachedProgram> cachedPrograms;
+
+// Program binary entry points, NULL where the context has none
+static bool binariesQueried = false;
+static GetProgramBinaryProc getProgramBinary = NULL;
+static ProgramBinaryProc programBinary = NULL;
+static ProgramParameteriProc programParameteri = NULL;
+static std::string binaryPath;          // Preferences directory, with trailing separator
+static unsigned long long driverHash;   // Binaries are only valid for the driver that built them
+
+// 64 bit FNV-1a, continuing from hash
+static unsigned long long fnv1a(const void* data, size_t length,
+                                unsigned long long hash = 0xcbf29ce484222325ull)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+static unsigned long long fnv1aString(const char* text, unsigned long long hash = 0xcbf29ce484222325ull)
+{
+    return text ? fnv1a(text, strlen(text) + 1, hash) : hash;
+}
+
+static void queryBinaries()
+{
+    binariesQueried = true;
+
+    // Core in OpenGL ES 3, but not in WebGL 2
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version && strncmp(version, "OpenGL ES ", 10) == 0 && version[10] >= '3' && !strstr(version, "WebGL"))
+    {
+        getProgramBinary = (GetProgramBinaryProc)SDL_GL_GetProcAddress("glGetProgramBinary");
+        programBinary = (ProgramBinaryProc)SDL_GL_GetProcAddress("glProgramBinary");
+        programParameteri = (ProgramParameteriProc)SDL_GL_GetProcAddress("glProgramParameteri");
+    }
+    else if (SDL_GL_ExtensionSupported("GL_OES_get_program_binary"))
+    {
+        getProgramBinary = (GetProgramBinaryProc)SDL_GL_GetProcAddress("glGetProgramBinaryOES");
+        programBinary = (ProgramBinaryProc)SDL_GL_GetProcAddress("glProgramBinaryOES");
+    }
+
+    // Drivers may support the entry points with no binary formats
+    GLint formats = 0;
+    if (getProgramBinary && programBinary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    char* prefPath = formats > 0 ? SDL_GetPrefPath("emscripten-sdl2-ogles2", "shaders") : NULL;
+    if (!prefPath)
+    {
+        getProgramBinary = NULL;
+        programBinary = NULL;
+        printf("INFO: Program binaries not cached\n");
+        return;
+    }
+    binaryPath = prefPath;
+    SDL_free(prefPath);
+
+    driverHash = fnv1aString((const char*)glGetString(GL_VENDOR));
+    driverHash = fnv1aString((const char*)glGetString(GL_RENDERER), driverHash);
+    driverHash = fnv1aString(version, driverHash);
+    printf("INFO: Program binaries cached in %s\n", binaryPath.c_str());
+}
+
+static std::string binaryFilename(unsigned long long hash)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", hash ^ driverHash);
+    return binaryPath + name;
+}
+
+static bool linked(GLuint program)
+{
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+// Create program from the binary saved by an earlier launch, if there is one the
+// driver still accepts. Returns 0 otherwise.
+static GLuint loadBinary(unsigned long long hash)
+{
+    FILE* file = fopen(binaryFilename(hash).c_str(), "rb");
+    if (!file)
+        return 0;
+
+    GLenum format = 0;
+    GLint length = 0;
+    std::vector<unsigned char> binary;
+    bool read = fread(&format, sizeof(format), 1, file) == 1 && fread(&length, sizeof(length), 1, file) == 1
+                && length > 0 && length < (64 << 20);
+    if (read)
+    {
+        binary.resize(length);
+        read = fread(&binary[0], 1, length, file) == (size_t)length;
+    }
+    fclose(file);
+    if (!read)
+        return 0;
+
+    GLuint program = glCreateProgram();
+    programBinary(program, format, &binary[0], length);
+    if (glGetError() != GL_NO_ERROR || !linked(program))
+    {
+        // Typically a driver update, the program is built from source and saved again
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void saveBinary(unsigned long long hash, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<unsigned char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    getProgramBinary(program, length, &written, &format, &binary[0]);
+    if (glGetError() != GL_NO_ERROR || written <= 0)
+        return;
+
+    std::string filename = binaryFilename(hash);
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file)
+        return;
+    bool saved = fwrite(&format, sizeof(format), 1, file) == 1 && fwrite(&written, sizeof(written), 1, file) == 1
+                 && fwrite(&binary[0], 1, written, file) == (size_t)written;
+    if (fclose(file) != 0 || !saved)
+    {
+        printf("ERROR: Failed to save program binary %s\n", filename.c_str());
+        remove(filename.c_str());
+    }
+}
+
+// Compiled shader of type and source, from the cache or compiled now. Returns 0 (and
+// prints the info log) if it fails to compile.
+static GLuint compileShader(GLenum type, const GLchar* source, int* compiled)
+{
+    unsigned long long hash = fnv1aString(source);
+    for (size_t i = 0; i < cachedShaders.size(); ++i)
+        if (cachedShaders[i].type == type && cachedShaders[i].hash == hash && cachedShaders[i].source == source)
+            return cachedShaders[i].shader;
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    ++*compiled;
+
+    GLint status = GL_FALSE, logLength = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    if (status != GL_TRUE)
+    {
+        std::vector<GLchar> log(logLength > 1 ? logLength : 1, '\0');
+        glGetShaderInfoLog(shader, (GLsizei)log.size(), NULL, &log[0]);
+        printf("ERROR: %s shader failed to compile:\n%s\n", type == GL_VERTEX_SHADER ? "Vertex" : "Fragment", &log[0]);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    CachedShader cached = {type, hash, source, shader};
+    cachedShaders.push_back(cached);
+    return shader;
+}
+
+GLuint shaderCacheProgram(const GLchar* vertexSource, const GLchar* fragmentSource, const char* const* attribs)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!binariesQueried)
+        queryBinaries();
+
+    std::string inputs(vertexSource, strlen(vertexSource) + 1);
+    inputs.append(fragmentSource, strlen(fragmentSource) + 1);
+    for (const char* const* attrib = attribs; attrib && *attrib; ++attrib)
+        inputs.append(*attrib, strlen(*attrib) + 1);
+    unsigned long long hash = fnv1a(inputs.data(), inputs.size());
+    for (size_t i = 0; i < cachedPrograms.size(); ++i)
+        if (cachedPrograms[i].hash == hash && cachedPrograms[i].inputs == inputs)
+            return cachedPrograms[i].program;
+
+    GLuint program = programBinary ? loadBinary(hash) : 0;
+    int compiled = 0;
+    bool fromBinary = program != 0;
+    if (!fromBinary)
+    {
+        GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, &compiled);
+        GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, &compiled);
+        if (!vertexShader || !fragmentShader)
+            return 0;
+
+        // Link vertex and fragment shader into shader program
+        program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        for (GLuint index = 0; attribs && attribs[index]; ++index)
+            glBindAttribLocation(program, index, attribs[index]);
+        if (programParameteri)
+            programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+
+        if (!linked(program))
+        {
+            GLint logLength = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+            std::vector<GLchar> log(logLength > 1 ? logLength : 1, '\0');
+            glGetProgramInfoLog(program, (GLsizei)log.size(), NULL, &log[0]);
+            printf("ERROR: Shader program failed to link:\n%s\n", &log[0]);
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        // The shaders stay attached, and cached, for other programs to share
+        if (getProgramBinary)
+            saveBinary(hash, program);
+    }
+
+    CachedProgram cached = {hash, inputs, program};
+    cachedPrograms.push_back(cached);
+
+    double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    if (fromBinary)
+        printf("OK: Shader program %u loaded from binary in %.2f ms\n", program, ms);
+    else
+        printf("OK: Shader program %u built in %.2f ms, %d of 2 shaders compiled\n", program, ms, compiled);
+    return program;
+}
+
+void shaderCacheClear()
+{
+    for (size_t i = 0; i < cachedPrograms.size(); ++i)
+        glDeleteProgram(cachedPrograms[i].program);
+    for (size_t i = 0; i < cachedShaders.size(); ++i)
+        glDeleteShader(cachedShaders[i].shader);
+    cachedPrograms.clear();
+    cachedShaders.clear();
+    binariesQueried = false;
+    getProgramBinary = NULL;
+    programBinary = NULL;
+    programParameteri = NULL;
+}
@@ -0,0 +1,22 @@
+//
+// Shader programs shared by the samples. Shader objects are cached by a hash of their
+// source, so programs sharing a vertex or fragment shader compile it once, and programs
+// by their shaders and attribute bindings. Where the context can return program binaries
+// (OpenGL ES 3, GL_OES_get_program_binary, never WebGL) linked programs are saved to the
+// SDL preferences directory and loaded from there on the next launch.
+//
+#pragma once
+#include <stddef.h>
+#include <SDL_opengles2.h>
+
+// Program of vertexSource and fragmentSource, compiled, linked and bound to the
+// attribute names in attribs, each at its index in the NULL terminated array (attribs
+// may be NULL). The same sources and attribs return the same program.
+// Compile and link failures print the info log and return 0.
+extern GLuint shaderCacheProgram(
+    const GLchar* vertexSource,
+    const GLchar* fragmentSource,
+    const char* const* attribs = NULL);
+
+// Delete every cached shader and program, as before the context is destroyed
+extern void shaderCacheClear();
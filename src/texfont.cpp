@@ -7,13 +7,36 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "bitexpand.h"
+#include "glstate.h"
+#include "sdf.h"
 #include "texfont.h"
 
 //#define TXF_DEBUG 1
 
+// Default string VBO cache budget, see txfSetStringCacheBudget
+#define TXF_STRING_CACHE_MAX_ENTRIES 256
+#define TXF_STRING_CACHE_MAX_BYTES (1024 * 1024)
+
+// Glyph quads per indexed draw call, limited by 16-bit indices
+#define TXF_MAX_QUADS_PER_DRAW (65536 / 4)
+
+// Memoized string widths per font, cleared when full, see txfGetStringWidth
+#define TXF_WIDTH_CACHE_MAX_ENTRIES 4096
+
+// Largest texture width or height a font file may have, keeping texel counts well within int
+#define TXF_MAX_TEX_SIZE 16384
+
 // byte swap a 32-bit value 
 inline void byteSwap32Bit(int* val)
 {
@@ -43,203 +66,287 @@ txfErrorString(void)
     return lastError;
 }
 
+// Two-level glyph index lookup: O(1), pages are only allocated where glyphs exist
+inline TexGlyphVertexInfo *
+lookupGlyph(TexFont * txf, unsigned int c)
+{
+    if (c >= TXF_GLYPH_PAGES * TXF_GLYPH_PAGE_SIZE)
+        return NULL;
+    TxfGlyphPage *page = txf->lut[c / TXF_GLYPH_PAGE_SIZE];
+    return page ? page->glyphs[c % TXF_GLYPH_PAGE_SIZE] : NULL;
+}
+
 static TexGlyphVertexInfo *
-getTCVI(TexFont * txf, int c)
+getTCVI(TexFont * txf, unsigned int c)
 {
-    // Automatically substitute uppercase letters with lowercase if not
-    // uppercase available (and vice versa). 
-    if ((c >= txf->min_glyph) && (c < txf->min_glyph + txf->range)) 
+    TexGlyphVertexInfo *tgvi = lookupGlyph(txf, c);
+    if (tgvi) 
+        return tgvi;
+
+    // Missing glyphs draw as the fallback glyph and are counted, not logged per frame
+    txf->missing_glyphs++;
+    txf->last_missing_glyph = c;
+    #ifdef TXF_DEBUG
+        if ((txf->missing_glyphs & (txf->missing_glyphs - 1)) == 0)
+            printf("texfont: %u unavailable font characters, last %u\n", txf->missing_glyphs, c);
+    #endif
+    return txf->fallback_glyph;
+}
+
+// Decode the UTF-8 code point at str, advancing str past it. Malformed sequences
+// decode to U+FFFD one byte at a time.
+static unsigned int
+decodeUTF8(const char **str, const char *end)
+{
+    const unsigned char *s = (const unsigned char *)*str;
+    unsigned int c = *s;
+    int extra = 0;
+    unsigned int min = 0;
+    if (c < 0x80)
+        extra = 0;
+    else if ((c & 0xe0) == 0xc0)
+        extra = 1, c &= 0x1f, min = 0x80;
+    else if ((c & 0xf0) == 0xe0)
+        extra = 2, c &= 0x0f, min = 0x800;
+    else if ((c & 0xf8) == 0xf0)
+        extra = 3, c &= 0x07, min = 0x10000;
+    else
     {
-        TexGlyphVertexInfo *tgvi = txf->lut[c - txf->min_glyph];
-        if (tgvi) 
-            return tgvi;
+        *str += 1;
+        return 0xfffd;
+    }
 
-        if (islower(c)) 
-        {
-            c = toupper(c);
-            if ((c >= txf->min_glyph) && (c < txf->min_glyph + txf->range))
-            {
-                return txf->lut[c - txf->min_glyph];
-            }
-        }
-        if (isupper(c)) 
+    if ((const char *)s + extra >= end)
+    {
+        *str += 1;
+        return 0xfffd;
+    }
+    for (int i = 1; i <= extra; ++i)
+    {
+        if ((s[i] & 0xc0) != 0x80)
         {
-            c = tolower(c);
-            if ((c >= txf->min_glyph) && (c < txf->min_glyph + txf->range)) 
-            {
-                return txf->lut[c - txf->min_glyph];
-            }
+            *str += 1;
+            return 0xfffd;
         }
+        c = (c << 6) | (s[i] & 0x3f);
     }
-    printf("texfont: tried to access unavailable font character \"%c\" (%d)\n", isprint(c) ? c : ' ', c);
-    return NULL;
+    if (c < min || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+    {
+        *str += 1;
+        return 0xfffd;
+    }
+    *str += 1 + extra;
+    return c;
 }
 
-void txfLoadFontError(const char* errorStr, TexFont *txf, FILE* file)
+unsigned int
+txfDecodeUTF8(const char **str, const char *end)
+{
+    return decodeUTF8(str, end);
+}
+
+// Texture coordinate in [0,1] to normalized unsigned short
+inline GLushort normalizeTexCoord(GLfloat t)
+{
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    return (GLushort)(t * 65535.0f + 0.5f);
+}
+
+inline TxfGlyphVertex glyphVertex(int x, int y, GLushort s, GLushort t)
+{
+    TxfGlyphVertex vertex;
+    vertex.x = (GLshort)x;
+    vertex.y = (GLshort)y;
+    vertex.s = s;
+    vertex.t = t;
+    return vertex;
+}
+
+void txfLoadFontError(const char* errorStr, TexFont *txf)
 {
     lastError = (char*)errorStr;
     printf("%s\n", lastError);
     txfUnloadFont(txf);
-    if (file)
-        fclose(file);
 }
 
-TexFont *
-txfLoadFont(const char *filename)
-{    
-    #define TXF_LOAD_ERROR(errorStr) { txfLoadFontError(errorStr, txf, file); return NULL; }
-    #define TXF_LOAD_EXPECT_GOT(n) if (got != n) { txfLoadFontError("premature end of file.", txf, file); return NULL; }
-
-    TexFont *txf = NULL;
+// Who owns TexFont::data, see txfUnloadFont
+enum TxfDataOwner {TXF_DATA_CALLER, TXF_DATA_MAPPED, TXF_DATA_HEAP};
 
-    FILE *file = fopen(filename, "rb");
-    if (file == NULL) 
-        TXF_LOAD_ERROR("file open failed.");
+// Read a 32-bit header field in place, without alignment assumptions
+inline int readInt32(const unsigned char* data, int swap)
+{
+    int val;
+    memcpy(&val, data, sizeof(int));
+    if (swap)
+        byteSwap32Bit(&val);
+    return val;
+}
 
-    txf = new TexFont;
+static TexFont *
+txfNewFont(const unsigned char *data, size_t size, int owner)
+{
+    TexFont *txf = new TexFont;
     if (txf == NULL) 
-        TXF_LOAD_ERROR("out of memory.");
+        return NULL;
 
+    txf->texobj = 0;
+    txf->quad_ibo = 0;
+    txf->quad_ibo_capacity = 0;
+    txf->tex_width = 0;
+    txf->tex_height = 0;
+    txf->max_ascent = 0;
+    txf->max_descent = 0;
+    txf->num_glyphs = 0;
+    txf->format = TXF_FORMAT_BYTE;
+    txf->sdf_spread = 0;
+    txf->min_glyph = 0;
+    txf->range = 0;
+    txf->data = data;
+    txf->data_size = size;
+    txf->data_owner = owner;
     txf->teximage = NULL;
+    txf->texstorage = NULL;
     txf->tgi = NULL;
-    txf->tgvi = NULL;
-    txf->lut = NULL;
+    txf->tgistorage = NULL;
+    for (int i = 0; i < TXF_GLYPH_PAGES; ++i)
+        txf->lut[i] = NULL;
+    txf->fallback_glyph = NULL;
+    txf->missing_glyphs = 0;
+    txf->last_missing_glyph = 0;
+
+    TxfStringCache& cache = txf->stringVBOs;
+    cache.max_entries = TXF_STRING_CACHE_MAX_ENTRIES;
+    cache.max_bytes = TXF_STRING_CACHE_MAX_BYTES;
+    cache.bytes = 0;
+    cache.hits = cache.misses = cache.evictions = 0;
+    return txf;
+}
+
+// Fill in the glyph quad, texels at x,y in the texture, quad corners relative to the pen
+static void
+txfSetGlyphQuad(const TexFont *txf, TexGlyphVertexInfo& tgvi,
+                int x, int y, int width, int height, int xoffset, int yoffset)
+{
+    GLfloat w = txf->tex_width, h = txf->tex_height;
+    GLfloat xstep = 0.5 / w, ystep = 0.5 / h;
+
+    int x0 = xoffset, y0 = yoffset,
+        x1 = xoffset + width, y1 = yoffset + height;
+    GLushort s0 = normalizeTexCoord(x / w + xstep),
+             t0 = normalizeTexCoord(y / h + ystep),
+             s1 = normalizeTexCoord((x + width) / w + xstep),
+             t1 = normalizeTexCoord((y + height) / h + ystep);
 
-    char fileid[4];
-    unsigned long got = fread(fileid, 1, 4, file);
-    if (got != 4 || strncmp(fileid, "\377txf", 4)) 
+    // Build glyph vertex array quad, stored as tristrip (4 vertices)
+    //
+    tgvi.vertices[0] = glyphVertex(x0, y1, s0, t1);
+    tgvi.vertices[1] = glyphVertex(x1, y1, s1, t1);
+    tgvi.vertices[2] = glyphVertex(x0, y0, s0, t0);
+    tgvi.vertices[3] = glyphVertex(x1, y0, s1, t0);
+}
+
+// Point the glyph index at tgvi for character c, returns 0 when out of memory
+static int
+txfIndexGlyph(TexFont *txf, unsigned int c, TexGlyphVertexInfo *tgvi)
+{
+    TxfGlyphPage *&page = txf->lut[c / TXF_GLYPH_PAGE_SIZE];
+    if (page == NULL)
+    {
+        page = new TxfGlyphPage;
+        if (page == NULL)
+            return 0;
+        for (int j = 0; j < TXF_GLYPH_PAGE_SIZE; ++j)
+            page->glyphs[j] = NULL;
+    }
+    page->glyphs[c % TXF_GLYPH_PAGE_SIZE] = tgvi;
+    return 1;
+}
+
+static TexFont *
+txfParseFont(const unsigned char *data, size_t size, int owner)
+{
+    #define TXF_LOAD_ERROR(errorStr) { txfLoadFontError(errorStr, txf); return NULL; }
+    #define TXF_LOAD_EXPECT(n) if ((unsigned long long)(n) > size - offset) { txfLoadFontError("premature end of file.", txf); return NULL; }
+
+    TexFont *txf = txfNewFont(data, size, owner);
+    if (txf == NULL) 
+        TXF_LOAD_ERROR("out of memory.");
+
+    size_t offset = 0;
+    if (size < 4 || strncmp((const char*)data, "\377txf", 4)) 
         TXF_LOAD_ERROR("not a texture font file.");
+    offset += 4;
 
     assert(sizeof(int) == 4);    // Ensure external file format size. 
-    int endianness, swap;
-    got = fread(&endianness, sizeof(int), 1, file);
-    if (got == 1 && endianness == 0x12345678) 
+    TXF_LOAD_EXPECT(4 * 7);
+    int endianness = readInt32(data + offset, 0), swap;
+    if (endianness == 0x12345678) 
         swap = 0;
-    else if (got == 1 && endianness == 0x78563412)
+    else if (endianness == 0x78563412)
         swap = 1;
     else 
         TXF_LOAD_ERROR("not a texture font file.");
 
-    int format; 
-    got = fread(&format, sizeof(int), 1, file);
-    TXF_LOAD_EXPECT_GOT(1);
-    got = fread(&txf->tex_width, sizeof(int), 1, file);
-    TXF_LOAD_EXPECT_GOT(1);
-    got = fread(&txf->tex_height, sizeof(int), 1, file);
-    TXF_LOAD_EXPECT_GOT(1);
-    got = fread(&txf->max_ascent, sizeof(int), 1, file);
-    TXF_LOAD_EXPECT_GOT(1);
-    got = fread(&txf->max_descent, sizeof(int), 1, file);
-    TXF_LOAD_EXPECT_GOT(1);
-    got = fread(&txf->num_glyphs, sizeof(int), 1, file);
-    TXF_LOAD_EXPECT_GOT(1);
-
-    if (swap) 
-    {
-        byteSwap32Bit(&format);
-        byteSwap32Bit(&txf->tex_width);
-        byteSwap32Bit(&txf->tex_height);
-        byteSwap32Bit(&txf->max_ascent);
-        byteSwap32Bit(&txf->max_descent);
-        byteSwap32Bit(&txf->num_glyphs);
-    }
-    txf->tgi = new TexGlyphInfo[txf->num_glyphs];
-    if (txf->tgi == NULL)
-        TXF_LOAD_ERROR("out of memory.");
+    int format = readInt32(data + offset + 4, swap);
+    txf->tex_width = readInt32(data + offset + 8, swap);
+    txf->tex_height = readInt32(data + offset + 12, swap);
+    txf->max_ascent = readInt32(data + offset + 16, swap);
+    txf->max_descent = readInt32(data + offset + 20, swap);
+    txf->num_glyphs = readInt32(data + offset + 24, swap);
+    offset += 4 * 7;
 
-    assert(sizeof(TexGlyphInfo) == 12);    // Ensure external file format size. 
-    got = fread(txf->tgi, sizeof(TexGlyphInfo), txf->num_glyphs, file);
-    TXF_LOAD_EXPECT_GOT(txf->num_glyphs);
+    if (txf->num_glyphs <= 0 || txf->tex_width <= 0 || txf->tex_height <= 0)
+        TXF_LOAD_ERROR("not a texture font file.");
+    if (txf->tex_width > TXF_MAX_TEX_SIZE || txf->tex_height > TXF_MAX_TEX_SIZE)
+        TXF_LOAD_ERROR("texture too large.");
 
-    if (swap) 
+    // Use the glyph table in place, unless it needs byte swapping or realigning.
+    // The glyph count is bounded by the bytes left before it is multiplied.
+    assert(sizeof(TexGlyphInfo) == 12);    // Ensure external file format size. 
+    if ((size_t)txf->num_glyphs > (size - offset) / sizeof(TexGlyphInfo))
+        TXF_LOAD_ERROR("premature end of file.");
+    const unsigned char *glyphTable = data + offset;
+    offset += sizeof(TexGlyphInfo) * txf->num_glyphs;
+    if (!swap && ((size_t)glyphTable % sizeof(short)) == 0)
+        txf->tgi = (const TexGlyphInfo*)glyphTable;
+    else
     {
-        for (int i = 0; i < txf->num_glyphs; i++) 
+        txf->tgistorage = new TexGlyphInfo[txf->num_glyphs];
+        if (txf->tgistorage == NULL)
+            TXF_LOAD_ERROR("out of memory.");
+        memcpy(txf->tgistorage, glyphTable, sizeof(TexGlyphInfo) * txf->num_glyphs);
+
+        if (swap) 
         {
-            byteSwap16Bit((short*)&txf->tgi[i].c);
-            byteSwap16Bit(&txf->tgi[i].x);
-            byteSwap16Bit(&txf->tgi[i].y);
+            for (int i = 0; i < txf->num_glyphs; i++) 
+            {
+                byteSwap16Bit((short*)&txf->tgistorage[i].c);
+                byteSwap16Bit(&txf->tgistorage[i].x);
+                byteSwap16Bit(&txf->tgistorage[i].y);
+            }
         }
+        txf->tgi = txf->tgistorage;
     }
-    txf->tgvi = new TexGlyphVertexInfo[txf->num_glyphs];
-    if (txf->tgvi == NULL) 
-        TXF_LOAD_ERROR("out of memory.");
-
-    GLfloat w = txf->tex_width, h = txf->tex_height;
-    GLfloat xstep = 0.5 / w, ystep = 0.5 / h;
+    txf->tgvi.resize(txf->num_glyphs);
 
     for (int i = 0; i < txf->num_glyphs; i++) 
     {
-        TexGlyphInfo *tgi = &txf->tgi[i];
-        txf->tgvi[i].t0[0] = tgi->x / w + xstep;
-        txf->tgvi[i].t0[1] = tgi->y / h + ystep;
-        txf->tgvi[i].v0[0] = tgi->xoffset;
-        txf->tgvi[i].v0[1] = tgi->yoffset;
-        txf->tgvi[i].t1[0] = (tgi->x + tgi->width) / w + xstep;
-        txf->tgvi[i].t1[1] = tgi->y / h + ystep;
-        txf->tgvi[i].v1[0] = tgi->xoffset + tgi->width;
-        txf->tgvi[i].v1[1] = tgi->yoffset;
-        txf->tgvi[i].t2[0] = (tgi->x + tgi->width) / w + xstep;
-        txf->tgvi[i].t2[1] = (tgi->y + tgi->height) / h + ystep;
-        txf->tgvi[i].v2[0] = tgi->xoffset + tgi->width;
-        txf->tgvi[i].v2[1] = tgi->yoffset + tgi->height;
-        txf->tgvi[i].t3[0] = tgi->x / w + xstep;
-        txf->tgvi[i].t3[1] = (tgi->y + tgi->height) / h + ystep;
-        txf->tgvi[i].v3[0] = tgi->xoffset;
-        txf->tgvi[i].v3[1] = tgi->yoffset + tgi->height;
-        txf->tgvi[i].advance = tgi->advance;
-
-        // Build glyph vertex array quad, stored as tristrip (4 vertices)
-        //
+        const TexGlyphInfo *tgi = &txf->tgi[i];
         TexGlyphVertexInfo& tgvi = txf->tgvi[i];
+
+        txfSetGlyphQuad(txf, tgvi, tgi->x, tgi->y, tgi->width, tgi->height, tgi->xoffset, tgi->yoffset);
+        tgvi.advance = tgi->advance;
+
         #ifdef TXF_DEBUG        
             printf ("tgvi #%d '%c'\n", i, tgi->c);
-            printf ("texCoord 0 %f,%f  ", tgvi.t0[0], tgvi.t0[1]);
-            printf ("position 0 %d,%d\n", tgvi.v0[0], tgvi.v0[1]);
-            printf ("texCoord 1 %f,%f  ", tgvi.t1[0], tgvi.t1[1]);
-            printf ("position 1 %d,%d\n", tgvi.v1[0], tgvi.v1[1]);
-            printf ("texCoord 2 %f,%f  ", tgvi.t2[0], tgvi.t2[1]);
-            printf ("position 2 %d,%d\n", tgvi.v2[0], tgvi.v2[1]);
-            printf ("texCoord 3 %f,%f  ", tgvi.t3[0], tgvi.t3[1]);
-            printf ("position 3 %d,%d\n", tgvi.v3[0], tgvi.v3[1]);
+            for (int j = 0; j < 4; ++j)
+                printf ("position %d %d,%d  texCoord %d %d,%d\n", j, tgvi.vertices[j].x, tgvi.vertices[j].y,
+                        j, tgvi.vertices[j].s, tgvi.vertices[j].t);
         #endif
 
-        GLfloat* va = tgvi.vertexArray;
-        int offset = 0;
-        va[offset+0] = tgvi.v3[0]; //0.0f;
-        va[offset+1] = tgvi.v3[1]; //1.0f;
-        va[offset+2] = 0.0f;
-        va[offset+3] = tgvi.t3[0];
-        va[offset+4] = tgvi.t3[1];
-
-        offset += 5;
-        va[offset+0] = tgvi.v2[0]; //1.0f;
-        va[offset+1] = tgvi.v2[1]; //1.0f;
-        va[offset+2] = 0.0f;
-        va[offset+3] = tgvi.t2[0];
-        va[offset+4] = tgvi.t2[1];
-
-        offset += 5;
-        va[offset+0] = tgvi.v0[0]; //0.0f;
-        va[offset+1] = tgvi.v0[1]; //0.0f;
-        va[offset+2] = 0.0f;
-        va[offset+3] = tgvi.t0[0];
-        va[offset+4] = tgvi.t0[1];
-
-        offset += 5;
-        va[offset+0] = tgvi.v1[0]; //1.0f;
-        va[offset+1] = tgvi.v1[1]; //0.0f;
-        va[offset+2] = 0.0f;
-        va[offset+3] = tgvi.t1[0];
-        va[offset+4] = tgvi.t1[1];       
-
         // Correct tgvi.advance read in from txf file
         // In rockfont.txf, advance = max x + min x, should be = max x - min x + letter spacing
-        GLfloat minX = va[0];
-        for (int i = 1; i < 4; ++i)
-        {
-            if (va[i * 5] < minX)
-                minX = va[i * 5];
-        }
+        GLfloat minX = tgi->xoffset;
         tgvi.advance -= (minX * 2.0f);
         const float letterSpacing = 3.0f;
         tgvi.advance += letterSpacing;
@@ -257,24 +364,46 @@ txfLoadFont(const char *filename)
     txf->min_glyph = min_glyph;
     txf->range = max_glyph - min_glyph + 1;
 
-    txf->lut = new TexGlyphVertexInfo*[txf->range];
-    if (txf->lut == NULL)
-        TXF_LOAD_ERROR("out of memory.");
-    for (int i = 0; i < txf->range; ++i)
-        txf->lut[i] = NULL;
     for (int i = 0; i < txf->num_glyphs; i++) 
-        txf->lut[txf->tgi[i].c - txf->min_glyph] = &txf->tgvi[i];
+    {
+        if (!txfIndexGlyph(txf, txf->tgi[i].c, &txf->tgvi[i]))
+            TXF_LOAD_ERROR("out of memory.");
+    }
+
+    // Automatically substitute uppercase letters with lowercase if not
+    // uppercase available (and vice versa), resolved once here by filling the holes
+    for (unsigned int c = 'A'; c <= 'Z'; ++c)
+    {
+        unsigned int lower = tolower(c);
+        TexGlyphVertexInfo *upperGlyph = lookupGlyph(txf, c), *lowerGlyph = lookupGlyph(txf, lower);
+        if (upperGlyph && !lowerGlyph)
+            txf->lut[0]->glyphs[lower] = upperGlyph;
+        else if (lowerGlyph && !upperGlyph)
+            txf->lut[0]->glyphs[c] = lowerGlyph;
+    }
+
+    // Characters without a glyph draw as '?', else space, else the first glyph
+    txf->fallback_glyph = lookupGlyph(txf, '?');
+    if (!txf->fallback_glyph)
+        txf->fallback_glyph = lookupGlyph(txf, ' ');
+    if (!txf->fallback_glyph)
+        txf->fallback_glyph = &txf->tgvi[0];
 
     switch (format) 
     {
+        case TXF_FORMAT_SDF:
+            {
+                TXF_LOAD_EXPECT(4);
+                txf->format = TXF_FORMAT_SDF;
+                txf->sdf_spread = readInt32(data + offset, swap);
+                offset += 4;
+            }
+            // Fall through, distance field texels are stored as bytes
         case TXF_FORMAT_BYTE:
             {
-                txf->teximage = new unsigned char[txf->tex_width * txf->tex_height];
-                if (txf->teximage == NULL)
-                    TXF_LOAD_ERROR("out of memory.");
-                got = fread(txf->teximage, 1, txf->tex_width * txf->tex_height, file);
-
-                TXF_LOAD_EXPECT_GOT(txf->tex_width * txf->tex_height);
+                // Texels are uploaded straight from the file data
+                TXF_LOAD_EXPECT((unsigned long long)txf->tex_width * txf->tex_height);
+                txf->teximage = data + offset;
 
                 #ifdef TXF_DEBUG
                     printf("TXF_FORMAT_BYTE\n");
@@ -290,29 +419,15 @@ txfLoadFont(const char *filename)
                 int width = txf->tex_width;
                 int height = txf->tex_height;
                 int stride = (width + 7) >> 3;
-                unsigned char *texbitmap = new unsigned char[stride * height];
-                if (texbitmap == NULL)
-                    TXF_LOAD_ERROR("out of memory.");
-
-                got = fread(texbitmap, 1, stride * height, file);
-                TXF_LOAD_EXPECT_GOT(stride * height);
+                TXF_LOAD_EXPECT((unsigned long long)stride * height);
+                const unsigned char *texbitmap = data + offset;
                 
-                txf->teximage = new unsigned char[width * height];
-                if (txf->teximage == NULL)
+                txf->texstorage = new unsigned char[(size_t)width * height];
+                if (txf->texstorage == NULL)
                     TXF_LOAD_ERROR("out of memory.");
                 
-                for (int i = 0; i < height; i++) 
-                {
-                    for (int j = 0; j < width; j++) 
-                    {
-                        if (texbitmap[i * stride + (j >> 3)] & (1 << (j & 7))) 
-                            txf->teximage[i * width + j] = 255;
-                        else
-                            txf->teximage[i * width + j] = 0;
-                    }
-                }
-                
-                delete[] texbitmap;
+                bitExpand(texbitmap, stride, txf->texstorage, width, height);
+                txf->teximage = txf->texstorage;
 
                 #ifdef TXF_DEBUG
                     printf("TXF_FORMAT_BITMAP\n");
@@ -322,12 +437,187 @@ txfLoadFont(const char *filename)
                 #endif
             }
             break;
+
+        default:
+            TXF_LOAD_ERROR("unknown texture font format.");
     }
 
+    return txf;
+
+    #undef TXF_LOAD_ERROR
+    #undef TXF_LOAD_EXPECT
+}
+
+TexFont *
+txfLoadFontFromMemory(const void *data, size_t size)
+{
+    return txfParseFont((const unsigned char*)data, size, TXF_DATA_CALLER);
+}
+
+TexFont *
+txfLoadFont(const char *filename)
+{
+    // Map the whole file read only: header, glyph table and texels are used in place
+#ifdef _WIN32
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) 
+    {
+        txfLoadFontError("file open failed.", NULL);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = size > 0 ? new unsigned char[size] : NULL;
+    size_t got = data ? fread(data, 1, size, file) : 0;
     fclose(file);
+    if (got != (size_t)size || size <= 0)
+    {
+        delete[] data;
+        txfLoadFontError("premature end of file.", NULL);
+        return NULL;
+    }
+    return txfParseFont(data, size, TXF_DATA_HEAP);
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) 
+    {
+        txfLoadFontError("file open failed.", NULL);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        txfLoadFontError("premature end of file.", NULL);
+        return NULL;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        txfLoadFontError("file map failed.", NULL);
+        return NULL;
+    }
+    return txfParseFont((const unsigned char*)data, st.st_size, TXF_DATA_MAPPED);
+#endif
+}
+
+TexFont *
+txfCreateFont(int tex_width, int tex_height, int max_ascent, int max_descent)
+{
+    TexFont *txf = txfNewFont(NULL, 0, TXF_DATA_CALLER);
+    if (txf == NULL)
+        return NULL;
+    txf->tex_width = tex_width;
+    txf->tex_height = tex_height;
+    txf->max_ascent = max_ascent;
+    txf->max_descent = max_descent;
+    txf->texstorage = new unsigned char[(size_t)tex_width * tex_height];
+    memset(txf->texstorage, 0, (size_t)tex_width * tex_height);
+    txf->teximage = txf->texstorage;
     return txf;
 }
 
+TexGlyphVertexInfo *
+txfAddGlyph(TexFont * txf, unsigned int c, int x, int y, int width, int height,
+            int xoffset, int yoffset, float advance)
+{
+    if (c >= TXF_GLYPH_PAGES * TXF_GLYPH_PAGE_SIZE)
+        return NULL;
+
+    // Always a new slot: a replaced glyph may also be the fallback or fill a case hole
+    int added = lookupGlyph(txf, c) == NULL;
+    txf->tgvi.push_back(TexGlyphVertexInfo());
+    TexGlyphVertexInfo *tgvi = &txf->tgvi.back();
+    if (!txfIndexGlyph(txf, c, tgvi))
+        return NULL;
+
+    // The glyph table read from file no longer describes the font, see txfWriteFont
+    txf->tgi = NULL;
+
+    if (added)
+    {
+        if (txf->num_glyphs == 0 || (int)c < txf->min_glyph)
+        {
+            int max_glyph = txf->num_glyphs ? txf->min_glyph + txf->range - 1 : (int)c;
+            txf->min_glyph = c;
+            txf->range = max_glyph - c + 1;
+        }
+        else if ((int)c >= txf->min_glyph + txf->range)
+            txf->range = c - txf->min_glyph + 1;
+        txf->num_glyphs++;
+    }
+    txfSetGlyphQuad(txf, *tgvi, x, y, width, height, xoffset, yoffset);
+    tgvi->advance = advance;
+
+    // Until then characters without a glyph draw as the first one added
+    if (txf->fallback_glyph == NULL)
+        txf->fallback_glyph = tgvi;
+
+    // Strings drawn with the fallback glyph in place of c are stale now
+    txf->widths.clear();
+    txfClearStringCache(txf);
+    return tgvi;
+}
+
+void
+txfConvertToSDF(TexFont * txf, int spread)
+{
+    // Texels used in place from the file are read only
+    if (txf->texstorage == NULL)
+        txf->texstorage = new unsigned char[(size_t)txf->tex_width * txf->tex_height];
+
+    sdfGenerate(txf->teximage, txf->tex_width, txf->texstorage, txf->tex_width,
+                txf->tex_width, txf->tex_height, spread);
+    txf->teximage = txf->texstorage;
+    txf->format = TXF_FORMAT_SDF;
+    txf->sdf_spread = spread;
+}
+
+int
+txfWriteFont(TexFont * txf, const char *filename)
+{
+    if (txf->tgi == NULL)
+    {
+        lastError = (char*)"no glyph table to write.";
+        return 0;
+    }
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+    {
+        lastError = (char*)"file open failed.";
+        return 0;
+    }
+
+    // Native byte order, readers swap as needed
+    int header[7] = {0x12345678, txf->format, txf->tex_width, txf->tex_height,
+                     txf->max_ascent, txf->max_descent, txf->num_glyphs};
+    size_t texels = (size_t)txf->tex_width * txf->tex_height;
+    bool ok = fwrite("\377txf", 1, 4, file) == 4 &&
+              fwrite(header, sizeof(int), 7, file) == 7 &&
+              fwrite(txf->tgi, sizeof(TexGlyphInfo), txf->num_glyphs, file) == (size_t)txf->num_glyphs &&
+              (txf->format != TXF_FORMAT_SDF || fwrite(&txf->sdf_spread, sizeof(int), 1, file) == 1) &&
+              fwrite(txf->teximage, 1, texels, file) == texels;
+    if (fclose(file) != 0)
+        ok = false;
+    if (!ok)
+        lastError = (char*)"file write failed.";
+    return ok;
+}
+
+int
+txfSetFallbackGlyph(TexFont * txf, unsigned int c)
+{
+    TexGlyphVertexInfo *tgvi = lookupGlyph(txf, c);
+    if (tgvi)
+    {
+        txf->fallback_glyph = tgvi;
+        txf->widths.clear();
+    }
+    return tgvi != NULL;
+}
+
 GLuint
 txfEstablishTexture(TexFont * txf, GLuint texobj)
 {
@@ -339,7 +629,7 @@ txfEstablishTexture(TexFont * txf, GLuint texobj)
             txf->texobj = texobj;
     }
  
-    glBindTexture(GL_TEXTURE_2D, txf->texobj);
+    glStateBindTexture(GL_TEXTURE_2D, txf->texobj);
     const GLenum format = GL_ALPHA; // r,g,b = 0,0,0; a = teximage
     glTexImage2D(GL_TEXTURE_2D, 0, format,
         txf->tex_width, txf->tex_height, 0,
@@ -351,7 +641,7 @@ txfEstablishTexture(TexFont * txf, GLuint texobj)
 void
 txfBindFontTexture(TexFont * txf)
 {
-    glBindTexture(GL_TEXTURE_2D, txf->texobj);
+    glStateBindTexture(GL_TEXTURE_2D, txf->texobj);
 }
 
 void
@@ -380,8 +670,11 @@ txfGetStringMetrics(
         } 
         else 
         {
-            tgvi = getTCVI(txf, string[i]);
-            w += tgvi->advance;
+            const char *c = string + i;
+            tgvi = getTCVI(txf, decodeUTF8(&c, string + len));
+            i = c - string - 1;
+            if (tgvi)
+                w += tgvi->advance;
         }
     }
     *width = w;
@@ -389,111 +682,187 @@ txfGetStringMetrics(
     *max_descent = txf->max_descent;
 }
 
-void
-txfRenderString(TexFont * txf, const char *str, float x, float y)
+// Delete least recently used string VBOs until the cache is within budget,
+// always keeping the newest keep entries (the VBO about to be drawn)
+static void
+txfEvictStringCache(TxfStringCache& cache, int keep)
 {
-    size_t numChars = strlen(str);
-    if (txf && numChars > 0)
+    while ((int)cache.lru.size() > keep
+           && ((cache.max_entries > 0 && (int)cache.lru.size() > cache.max_entries)
+               || (cache.max_bytes > 0 && cache.bytes > cache.max_bytes)))
     {
-        const GLint vertexPositionFloats = 3, // x,y,z
-                    vertexTexCoordFloats = 2, // u,v
-                    vertexFloats = vertexPositionFloats + vertexTexCoordFloats, // x,y,z + u,v = 5
-                    vertexBytes = vertexFloats * sizeof(GLfloat),
-                    quadVertices = 6, // two independent triangles = 6 vertices
-                    quadFloats = vertexFloats * quadVertices, // 5 * 6 = 30 floats
-                    vertexArrayVertices = quadVertices * numChars, // 6 * numchars
-                    vertexArrayFloats = vertexFloats * vertexArrayVertices, // 5 * 6 * numchars
-                    vertexArrayBytes = vertexBytes * vertexArrayVertices;
+        TxfStringVBO& lru = cache.lru.back();
+        glStateDeleteBuffers(1, &lru.vbo);
+        cache.bytes -= lru.bytes;
+        cache.index.erase(lru.str);
+        cache.lru.pop_back();
+        cache.evictions++;
+    }
+}
 
-        GLuint quadsVboId = 0;
+void
+txfSetStringCacheBudget(TexFont * txf, int max_entries, int max_bytes)
+{
+    txf->stringVBOs.max_entries = max_entries;
+    txf->stringVBOs.max_bytes = max_bytes;
+    txfEvictStringCache(txf->stringVBOs, 0);
+}
 
-        auto stringVBO = txf->stringVBOs.find(str);
-        if (stringVBO == txf->stringVBOs.end())
-        {
-            // Not found - build VBO and add to map
-            GLfloat* stringVertexArray = new GLfloat[vertexArrayFloats];
+void
+txfClearStringCache(TexFont * txf)
+{
+    TxfStringCache& cache = txf->stringVBOs;
+    for (auto stringVBO = cache.lru.begin(); stringVBO != cache.lru.end(); ++stringVBO)
+        glStateDeleteBuffers(1, &stringVBO->vbo);
+    cache.lru.clear();
+    cache.index.clear();
+    cache.bytes = 0;
+}
 
-            // Start advance at caller specified x
-            GLfloat advance = x;
+// Append a quad per glyph of the len bytes at str, placed at x,y, returning the number of quads appended
+static int
+txfBuildStringQuads(TexFont * txf, const char *str, int len, GLfloat x, GLfloat y, std::vector<TxfGlyphVertex>& quads)
+{
+    if (len <= 0)
+        return 0;
+    size_t first = quads.size();
+    quads.resize(first + 4 * len);  // Upper bound, UTF-8 has at most one glyph per byte
+    TxfGlyphVertex* quad = &quads[first];
+
+    // Start advance at caller specified x
+    GLfloat advance = x;
+    GLshort dy = (GLshort)floorf(y + 0.5f);
+    int numQuads = 0;
 
-            for (int i = 0; i < numChars; ++i)
+    const char *end = str + len;
+    for (const char *c = str; c < end; )
+    {
+        TexGlyphVertexInfo *tgvi = getTCVI(txf, decodeUTF8(&c, end));
+        if (tgvi)
+        {
+            // Copy char's quad, translated by accumulated advance and caller y
+            GLshort dx = (GLshort)floorf(advance + 0.5f);
+            for (int j = 0; j < 4; ++j)
             {
-                char c = str[i];
-                int quadIndex = i * quadFloats;
-
-                TexGlyphVertexInfo *tgvi = getTCVI(txf, c);
-                if (tgvi)
-                {
-                    // Copy char's vertexArray into stringVertexArray
-                    // Triangle #1
-                    for (int j = 0; j < 3; ++j) // vertices
-                        for (int k = 0; k < 5; ++k) // floats x,y,z,u,v
-                            stringVertexArray[i * 5 * 6 + j * 5 + k] = tgvi->vertexArray[j * 5 + k];
-
-                    // Triangle #2
-                    for (int j = 3; j < 6; ++j) // vertices
-                        for (int k = 0; k < 5; ++k) // floats x,y,z,u,v
-                            stringVertexArray[i * 5 * 6 + j * 5 + k] = tgvi->vertexArray[(j - 2) * 5 + k];
-
-
-                    // Translate x positions by accumulated advance
-                    // Translate y positions by caller specified y
-                    for (int j = 0; j < 6; ++j)
-                    {
-                        stringVertexArray[i * 5 * 6 + j * 5] += advance;
-                        stringVertexArray[i * 5 * 6 + j * 5 + 1] += y;
-                    }
-
-                    advance += tgvi->advance;
-
-                    #ifdef TXF_DEBUG
-                        for (int i = 0; i < 4; ++i)
-                        {
-                            GLfloat* va = tgvi->vertexArray;
-                            printf("tgvi va pos[%d] (%f,%f,%f) tex[%d] (%f,%f)\n",
-                                    i, va[i*5], va[i*5+1], va[i*5+2],
-                                    i, va[i*5+3], va[i*5+4]);
-                        }
-                        printf ("tgvi advance %f\n", tgvi->advance);
-
-                        for (int i = 0; i < numVertices; ++i)
-                        {
-                            GLfloat* va = stringVertexArray;
-                            printf("strva pos[%d] (%f,%f,%f) tex[%d] (%f,%f)\n",
-                                    i, va[i*5], va[i*5+1], va[i*5+2],
-                                    i, va[i*5+3], va[i*5+4]);
-                        }
-                    #endif
-                }
+                quad[j] = tgvi->vertices[j];
+                quad[j].x += dx;
+                quad[j].y += dy;
             }
+            quad += 4;
+            numQuads++;
+            advance += tgvi->advance;
+        }
+    }
+
+    quads.resize(first + 4 * numQuads);
+    return numQuads;
+}
+
+// Bind the font's shared quad index buffer, grown to index numQuads quads (up to TXF_MAX_QUADS_PER_DRAW)
+static void
+txfBindQuadIndices(TexFont * txf, int numQuads)
+{
+    if (txf->quad_ibo == 0)
+        glGenBuffers(1, &txf->quad_ibo);
+    glStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, txf->quad_ibo);
+
+    if (numQuads > TXF_MAX_QUADS_PER_DRAW)
+        numQuads = TXF_MAX_QUADS_PER_DRAW;
+    if (numQuads > txf->quad_ibo_capacity)
+    {
+        int capacity = txf->quad_ibo_capacity ? txf->quad_ibo_capacity : 64;
+        while (capacity < numQuads)
+            capacity *= 2;
+        if (capacity > TXF_MAX_QUADS_PER_DRAW)
+            capacity = TXF_MAX_QUADS_PER_DRAW;
+
+        std::vector<GLushort> indices(capacity * 6);
+        for (int i = 0; i < capacity; ++i)
+        {
+            GLushort base = (GLushort)(i * 4);
+            GLushort* idx = &indices[i * 6];
+            // Tristrip quad as two triangles: (v0,v1,v2) and (v1,v2,v3)
+            idx[0] = base + 0; idx[1] = base + 1; idx[2] = base + 2;
+            idx[3] = base + 1; idx[4] = base + 2; idx[5] = base + 3;
+        }
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), &indices[0], GL_STATIC_DRAW);
+        txf->quad_ibo_capacity = capacity;
+    }
+}
+
+// Draw numQuads glyph quads from the bound VBO, returning the number of draw calls
+static int
+txfDrawQuads(TexFont * txf, int numQuads)
+{
+    txfBindQuadIndices(txf, numQuads);
+
+    // One draw call, or one per TXF_MAX_QUADS_PER_DRAW when indices would overflow 16 bits
+    int drawCalls = 0;
+    for (int first = 0; first < numQuads; first += TXF_MAX_QUADS_PER_DRAW)
+    {
+        int count = numQuads - first;
+        if (count > TXF_MAX_QUADS_PER_DRAW)
+            count = TXF_MAX_QUADS_PER_DRAW;
+
+        // x,y as shorts, s,t as normalized unsigned shorts
+        size_t offset = (size_t)first * 4 * sizeof(TxfGlyphVertex);
+        glStateVertexAttribPointer(TXF_ATTRIB_POSITION, 2, GL_SHORT, GL_FALSE, sizeof(TxfGlyphVertex), (const void*)offset);
+        offset += 2 * sizeof(GLshort);
+        glStateVertexAttribPointer(TXF_ATTRIB_TEXCOORD, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(TxfGlyphVertex), (const void*)offset);
+
+        glDrawElements(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, 0);
+        drawCalls++;
+    }
+    return drawCalls;
+}
+
+void
+txfRenderString(TexFont * txf, const char *str, float x, float y)
+{
+    if (txf && *str)
+    {
+        GLuint quadsVboId = 0;
+        int numQuads = 0;
+
+        TxfStringCache& cache = txf->stringVBOs;
+        auto stringVBO = cache.index.find(str);
+        if (stringVBO == cache.index.end())
+        {
+            // Not found - build VBO and add to cache
+            cache.misses++;
+
+            // Build in string local space, caller x,y is applied at draw time so
+            // one cached VBO serves every placement of the string
+            std::vector<TxfGlyphVertex> quads;
+            numQuads = txfBuildStringQuads(txf, str, strlen(str), 0.0f, 0.0f, quads);
+            int bytes = quads.size() * sizeof(TxfGlyphVertex);
 
             // Build VBO
             glGenBuffers(1, &quadsVboId);
-            glBindBuffer(GL_ARRAY_BUFFER, quadsVboId);
-            glBufferData(GL_ARRAY_BUFFER, 5 * 6 * numChars * sizeof(GLfloat), stringVertexArray, GL_STATIC_DRAW);
-            delete[] stringVertexArray;
+            glStateBindBuffer(GL_ARRAY_BUFFER, quadsVboId);
+            glBufferData(GL_ARRAY_BUFFER, bytes, quads.empty() ? NULL : &quads[0], GL_STATIC_DRAW);
 
-            // Cache the string/VBO pair
-            txf->stringVBOs.insert({str, quadsVboId});
+            // Cache the string/VBO pair as most recently used, then evict down to budget
+            cache.lru.push_front({str, quadsVboId, bytes, numQuads});
+            cache.index[str] = cache.lru.begin();
+            cache.bytes += bytes;
+            txfEvictStringCache(cache, 1);
         }
         else 
         {
-            // Found - bind VBO
-            quadsVboId = stringVBO->second;
-            glBindBuffer(GL_ARRAY_BUFFER, quadsVboId);
+            // Found - mark most recently used and bind VBO
+            cache.hits++;
+            cache.lru.splice(cache.lru.begin(), cache.lru, stringVBO->second);
+            quadsVboId = stringVBO->second->vbo;
+            numQuads = stringVBO->second->quads;
+            glStateBindBuffer(GL_ARRAY_BUFFER, quadsVboId);
         }
 
-        // Draw the string VBO
-        if (quadsVboId != 0)
+        // Draw the string VBO, placed with a constant (array disabled) offset attribute
+        if (quadsVboId != 0 && numQuads > 0)
         {
-            const GLuint vertexPositionIndex = 0, 
-                         vertexTexCoordIndex = 1;            
-            GLuint offset = 0;
-            glVertexAttribPointer(vertexPositionIndex, vertexPositionFloats, GL_FLOAT, GL_FALSE, vertexFloats * sizeof(GLfloat), (const void*)offset);
-            offset += vertexPositionFloats * sizeof(GLfloat);
-            glVertexAttribPointer(vertexTexCoordIndex, vertexTexCoordFloats, GL_FLOAT, GL_FALSE, vertexFloats * sizeof(GLfloat), (const void*)offset);
-
-            glDrawArrays(GL_TRIANGLES, 0, vertexArrayVertices);
+            glVertexAttrib2f(TXF_ATTRIB_OFFSET, x, y);
+            txfDrawQuads(txf, numQuads);
         }
     }
 }
@@ -504,15 +873,221 @@ txfUnloadFont(TexFont * txf)
     if (txf)
     {
         if (txf->texobj != 0)
-            glDeleteTextures(1, &txf->texobj);
+            glStateDeleteTextures(1, &txf->texobj);
+        if (txf->quad_ibo != 0)
+            glStateDeleteBuffers(1, &txf->quad_ibo);
 
-        for (auto stringVBO = txf->stringVBOs.begin(); stringVBO != txf->stringVBOs.end(); ++stringVBO)
-            glDeleteBuffers(1, &stringVBO->second);
+        txfClearStringCache(txf);
 
-        delete[] txf->teximage;
-        delete[] txf->tgi;
-        delete[] txf->tgvi;
-        delete[] txf->lut;
+        delete[] txf->texstorage;
+        delete[] txf->tgistorage;
+        for (int i = 0; i < TXF_GLYPH_PAGES; ++i)
+            delete txf->lut[i];
+
+        if (txf->data_owner == TXF_DATA_HEAP)
+            delete[] txf->data;
+#ifndef _WIN32
+        else if (txf->data_owner == TXF_DATA_MAPPED)
+            munmap((void*)txf->data, txf->data_size);
+#endif
         delete txf;
     }
-}
\ No newline at end of file
+}
+
+TxfTextBatch *
+txfCreateTextBatch(TexFont * txf)
+{
+    TxfTextBatch *batch = new TxfTextBatch;
+    batch->txf = txf;
+    batch->vbo = 0;
+    batch->vbo_capacity = 0;
+    txfBeginTextBatch(batch);
+    return batch;
+}
+
+void
+txfDestroyTextBatch(TxfTextBatch * batch)
+{
+    if (batch)
+    {
+        if (batch->vbo != 0)
+            glStateDeleteBuffers(1, &batch->vbo);
+        delete batch;
+    }
+}
+
+void
+txfBeginTextBatch(TxfTextBatch * batch)
+{
+    batch->vertices.clear();
+    batch->stats.glyphs = 0;
+    batch->stats.bytes_uploaded = 0;
+    batch->stats.draw_calls = 0;
+}
+
+void
+txfBatchString(TxfTextBatch * batch, const char *str, float x, float y)
+{
+    if (batch->txf)
+        txfBuildStringQuads(batch->txf, str, strlen(str), x, y, batch->vertices);
+}
+
+void
+txfFlushTextBatch(TxfTextBatch * batch)
+{
+    const int quadBytes = 4 * sizeof(TxfGlyphVertex);
+
+    int numQuads = batch->vertices.size() / 4;
+    if (numQuads == 0)
+        return;
+
+    // Stream all quads into the persistent VBO, orphaning last frame's storage
+    if (batch->vbo == 0)
+        glGenBuffers(1, &batch->vbo);
+    glStateBindBuffer(GL_ARRAY_BUFFER, batch->vbo);
+    if (numQuads > batch->vbo_capacity)
+    {
+        int capacity = batch->vbo_capacity ? batch->vbo_capacity : 64;
+        while (capacity < numQuads)
+            capacity *= 2;
+        batch->vbo_capacity = capacity;
+    }
+    glBufferData(GL_ARRAY_BUFFER, batch->vbo_capacity * quadBytes, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, numQuads * quadBytes, &batch->vertices[0]);
+    batch->stats.bytes_uploaded += numQuads * quadBytes;
+
+    // Batched quads are already placed, so zero the constant offset attribute
+    glVertexAttrib2f(TXF_ATTRIB_OFFSET, 0.0f, 0.0f);
+    batch->stats.draw_calls += txfDrawQuads(batch->txf, numQuads);
+    batch->stats.glyphs += numQuads;
+
+    batch->vertices.clear();
+}
+
+float
+txfGetStringWidth(TexFont * txf, const char *str, int len)
+{
+    std::string key(str, len);
+    auto width = txf->widths.find(key);
+    if (width != txf->widths.end())
+        return width->second;
+
+    float w = 0.0f;
+    const char *end = str + len;
+    for (const char *c = str; c < end; )
+    {
+        // Fonts created empty have no glyph to fall back on until one is added
+        TexGlyphVertexInfo *tgvi = getTCVI(txf, decodeUTF8(&c, end));
+        if (tgvi)
+            w += tgvi->advance;
+    }
+
+    if (txf->widths.size() >= TXF_WIDTH_CACHE_MAX_ENTRIES)
+        txf->widths.clear();
+    txf->widths[key] = w;
+    return w;
+}
+
+// A line of laid out text, bytes [start, end) of the source string
+struct TxfLayoutLine
+{
+    int start, end;
+    float width;
+};
+
+// Greedy word wrap of one paragraph (no '\n') into lines no wider than maxWidth when possible.
+// Words are separated by spaces; a word wider than maxWidth gets a line of its own.
+static void
+txfWrapParagraph(TexFont * txf, const char *str, int start, int end, float maxWidth, std::vector<TxfLayoutLine>& lines)
+{
+    TxfLayoutLine line = {start, start, 0.0f};
+    bool lineEmpty = true;
+    int pos = start;
+    while (pos < end)
+    {
+        // Next space run and word
+        int spaceStart = pos;
+        while (pos < end && str[pos] == ' ')
+            ++pos;
+        int wordStart = pos;
+        while (pos < end && str[pos] != ' ')
+            ++pos;
+        if (wordStart == pos)
+            break; // Trailing spaces
+
+        float spaceWidth = txfGetStringWidth(txf, str + spaceStart, wordStart - spaceStart),
+              wordWidth = txfGetStringWidth(txf, str + wordStart, pos - wordStart);
+        if (lineEmpty)
+        {
+            // Leading spaces of a paragraph are kept, as indentation
+            line.width = spaceWidth + wordWidth;
+            lineEmpty = false;
+        }
+        else if (maxWidth > 0.0f && line.width + spaceWidth + wordWidth > maxWidth)
+        {
+            lines.push_back(line);
+            line.start = wordStart;
+            line.width = wordWidth;
+        }
+        else
+            line.width += spaceWidth + wordWidth;
+        line.end = pos;
+    }
+    lines.push_back(line);
+}
+
+void
+txfLayoutText(TexFont * txf, const char *str, float max_width, TxfAlign align, TxfLayout * layout)
+{
+    layout->vertices.clear();
+    layout->lines = 0;
+    layout->width = 0.0f;
+    layout->height = 0.0f;
+
+    // Break into lines at '\n' and by word wrapping
+    std::vector<TxfLayoutLine> lines;
+    int len = strlen(str);
+    for (int start = 0; start <= len; )
+    {
+        const char *newline = strchr(str + start, '\n');
+        int end = newline ? newline - str : len;
+        txfWrapParagraph(txf, str, start, end, max_width, lines);
+        start = end + 1;
+    }
+
+    for (size_t i = 0; i < lines.size(); ++i)
+        if (lines[i].width > layout->width)
+            layout->width = lines[i].width;
+
+    // Lines go down from the top left origin, aligned within max_width (or the widest line)
+    float boxWidth = max_width > 0.0f ? max_width : layout->width;
+    float lineHeight = txf->max_ascent + txf->max_descent;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        // Blank lines only take up their height
+        if (lines[i].end == lines[i].start)
+            continue;
+        float x = 0.0f;
+        if (align == TXF_ALIGN_CENTER)
+            x = (boxWidth - lines[i].width) * 0.5f;
+        else if (align == TXF_ALIGN_RIGHT)
+            x = boxWidth - lines[i].width;
+        float y = -(txf->max_ascent + i * lineHeight);
+        txfBuildStringQuads(txf, str + lines[i].start, lines[i].end - lines[i].start, x, y, layout->vertices);
+    }
+    layout->lines = lines.size();
+    layout->height = lines.size() * lineHeight;
+}
+
+void
+txfBatchLayout(TxfTextBatch * batch, const TxfLayout * layout, float x, float y)
+{
+    GLshort dx = (GLshort)floorf(x + 0.5f), dy = (GLshort)floorf(y + 0.5f);
+    size_t first = batch->vertices.size();
+    batch->vertices.insert(batch->vertices.end(), layout->vertices.begin(), layout->vertices.end());
+    for (size_t i = first; i < batch->vertices.size(); ++i)
+    {
+        batch->vertices[i].x += dx;
+        batch->vertices[i].y += dy;
+    }
+}
@@ -4,11 +4,22 @@
 // https://github.com/markkilgard/glut/tree/master/progs/texfont
 // https://web.archive.org/web/20010616211947/http://reality.sgi.com/opengl/tips/TexFont/TexFont.html
 //
+#include <deque>
+#include <list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <SDL_opengles2.h>
 
-enum TxfFormat {TXF_FORMAT_BYTE, TXF_FORMAT_BITMAP};
+// On-disk texel formats. TXF_FORMAT_SDF is TXF_FORMAT_BYTE holding a signed distance
+// field (see sdf.h), with its spread stored as a 32-bit int ahead of the texels.
+// Draw it with linear filtering and a threshold at 0.5 alpha, see txfConvertToSDF.
+enum TxfFormat {TXF_FORMAT_BYTE, TXF_FORMAT_BITMAP, TXF_FORMAT_SDF};
+
+// Vertex attribute indices used by txfRenderString and text batches. Text shaders
+// bind "position", "texCoord" and "offset" to these, and add offset to position:
+// cached string VBOs are in string local space, placed by a constant offset attribute.
+enum TxfVertexAttrib {TXF_ATTRIB_POSITION, TXF_ATTRIB_TEXCOORD, TXF_ATTRIB_OFFSET};
 
 typedef struct {
     unsigned short c;       // Potentially support 16-bit glyphs.
@@ -22,43 +33,158 @@ typedef struct {
     short y;
 } TexGlyphInfo;
 
+// Packed glyph quad vertex, 8 bytes: position in texels relative to the string
+// origin (strings are limited to +/-32767 texels), texture coordinate normalized
+// to [0,65535]. Drawn as GL_SHORT and normalized GL_UNSIGNED_SHORT attributes.
+typedef struct {
+    GLshort x;
+    GLshort y;
+    GLushort s;
+    GLushort t;
+} TxfGlyphVertex;
+
 typedef struct {
-    GLfloat t0[2];
-    GLshort v0[2];
-    GLfloat t1[2];
-    GLshort v1[2];
-    GLfloat t2[2];
-    GLshort v2[2];
-    GLfloat t3[2];
-    GLshort v3[2];
+    TxfGlyphVertex vertices[4];     // Quad in tristrip order, drawn with shared quad indices
     GLfloat advance;
-    GLfloat vertexArray[(3+2)*4];
 } TexGlyphVertexInfo;
 
+// Sparse two-level glyph index over 16-bit code points: memory grows with the
+// pages holding glyphs rather than with the code point range.
+#define TXF_GLYPH_PAGE_SIZE 256
+#define TXF_GLYPH_PAGES 256
+
+typedef struct {
+    TexGlyphVertexInfo *glyphs[TXF_GLYPH_PAGE_SIZE];
+} TxfGlyphPage;
+
+// Cached string VBO, kept in least recently used order
+typedef struct {
+    std::string str;
+    GLuint vbo;
+    int bytes;
+    int quads;
+} TxfStringVBO;
+
+// Size bounded string VBO cache, evicting (and deleting) least recently used VBOs
+// once either the entry or the byte budget is exceeded. A budget of 0 is unbounded.
+typedef struct {
+    std::list<TxfStringVBO> lru;    // Most recently used first
+    std::unordered_map<std::string, std::list<TxfStringVBO>::iterator> index;
+    int max_entries;
+    int max_bytes;
+    int bytes;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+} TxfStringCache;
+
 typedef struct {
     GLuint texobj;
+    GLuint quad_ibo;                    // Shared quad index buffer for all string draws
+    int quad_ibo_capacity;              // In quads
     int tex_width;
     int tex_height;
     int max_ascent;
     int max_descent;
     int num_glyphs;
+    int format;                         // Texels in teximage: TXF_FORMAT_BYTE or TXF_FORMAT_SDF
+    int sdf_spread;                     // Distance field range in texels, TXF_FORMAT_SDF only
     int min_glyph;
     int range;
-    unsigned char *teximage;
-    TexGlyphInfo *tgi;
-    TexGlyphVertexInfo *tgvi;
-    TexGlyphVertexInfo **lut;
-    std::unordered_map<std::string, GLuint> stringVBOs;
+    const unsigned char *data;          // .txf file contents, mapped or caller supplied
+    size_t data_size;
+    int data_owner;
+    const unsigned char *teximage;      // Points into data, or texstorage when expanded
+    unsigned char *texstorage;
+    const TexGlyphInfo *tgi;            // Points into data, or tgistorage when byte swapped
+    TexGlyphInfo *tgistorage;
+    std::deque<TexGlyphVertexInfo> tgvi;    // Grows with txfAddGlyph, element addresses stay valid
+    TxfGlyphPage *lut[TXF_GLYPH_PAGES]; // Glyph index, lut[c / page size]->glyphs[c % page size]
+    TexGlyphVertexInfo *fallback_glyph; // Drawn for characters the font lacks
+    unsigned int missing_glyphs;        // Characters drawn or measured with the fallback glyph
+    unsigned int last_missing_glyph;
+    std::unordered_map<std::string, float> widths;  // Memoized txfGetStringWidth results
+    TxfStringCache stringVBOs;
 } TexFont;
 
+// Batched text: strings added between txfBeginTextBatch and txfFlushTextBatch
+// are written into one streaming VBO and drawn with a single indexed draw call.
+typedef struct {
+    int glyphs;             // Glyph quads drawn since txfBeginTextBatch
+    int bytes_uploaded;     // Vertex bytes uploaded since txfBeginTextBatch
+    int draw_calls;         // Draw calls issued since txfBeginTextBatch
+} TxfBatchStats;
+
+typedef struct {
+    TexFont *txf;
+    GLuint vbo;
+    int vbo_capacity;       // In glyph quads
+    std::vector<TxfGlyphVertex> vertices;
+    TxfBatchStats stats;
+} TxfTextBatch;
+
+enum TxfAlign {TXF_ALIGN_LEFT, TXF_ALIGN_CENTER, TXF_ALIGN_RIGHT};
+
+// Laid out text: glyph quads placed relative to the top left corner (lines go down),
+// ready to be added to a batch with txfBatchLayout
+typedef struct {
+    std::vector<TxfGlyphVertex> vertices;
+    int lines;
+    float width;            // Widest line
+    float height;           // Lines times line height (max_ascent + max_descent)
+} TxfLayout;
+
 extern char *txfErrorString(void);
 
 extern TexFont *txfLoadFont(
     const char *filename);
 
+// Load from .txf file contents already in memory (e.g. Emscripten preloaded data),
+// parsed in place without copying: data must outlive the returned font.
+extern TexFont *txfLoadFontFromMemory(
+    const void *data,
+    size_t size);
+
 extern void txfUnloadFont(
     TexFont * txf);
 
+// Replace the texels with their signed distance field, spread texels either side of
+// glyph edges. Glyphs need spread texels of space around them in the texture for
+// their outer field to be exact. Call before txfEstablishTexture (or call it again).
+extern void txfConvertToSDF(
+    TexFont * txf,
+    int spread);
+
+// Write the font as TXF_FORMAT_BYTE, or TXF_FORMAT_SDF once converted. Only loaded fonts
+// without glyphs added since have a glyph table to write. Returns 0 on failure.
+extern int txfWriteFont(
+    TexFont * txf,
+    const char *filename);
+
+// Create an empty font with a zeroed tex_width x tex_height alpha texture in
+// texstorage, for glyphs rasterized at run time and added with txfAddGlyph
+extern TexFont *txfCreateFont(
+    int tex_width,
+    int tex_height,
+    int max_ascent,
+    int max_descent);
+
+// Add (or replace) glyph c, its texels at x,y in the texture (rows bottom up, as
+// in .txf files) and its quad at xoffset,yoffset from the pen. Cached strings and
+// widths are invalidated, texels must be uploaded by the caller.
+extern TexGlyphVertexInfo *txfAddGlyph(
+    TexFont * txf,
+    unsigned int c,
+    int x, int y,
+    int width, int height,
+    int xoffset, int yoffset,
+    float advance);
+
+// Draw characters the font lacks as glyph c, returns 0 if the font has no glyph c
+extern int txfSetFallbackGlyph(
+    TexFont * txf,
+    unsigned int c);
+
 extern GLuint txfEstablishTexture(
     TexFont * txf,
     GLuint texobj);
@@ -66,6 +192,12 @@ extern GLuint txfEstablishTexture(
 extern void txfBindFontTexture(
     TexFont * txf);
 
+// Decode the UTF-8 code point at *str and advance *str past it, U+FFFD if malformed
+extern unsigned int txfDecodeUTF8(
+    const char **str,
+    const char *end);
+
+// Strings are UTF-8, len is in bytes
 extern void txfGetStringMetrics(
     TexFont * txf,
     const char *str,
@@ -78,3 +210,48 @@ extern void txfRenderString(
     TexFont * txf,
     const char *string,
     float x, float y);
+
+extern void txfSetStringCacheBudget(
+    TexFont * txf,
+    int max_entries,
+    int max_bytes);
+
+extern void txfClearStringCache(
+    TexFont * txf);
+
+extern TxfTextBatch *txfCreateTextBatch(
+    TexFont * txf);
+
+extern void txfDestroyTextBatch(
+    TxfTextBatch * batch);
+
+extern void txfBeginTextBatch(
+    TxfTextBatch * batch);
+
+extern void txfBatchString(
+    TxfTextBatch * batch,
+    const char *string,
+    float x, float y);
+
+extern void txfFlushTextBatch(
+    TxfTextBatch * batch);
+
+// Width of the len bytes of UTF-8 at str, memoized per font
+extern float txfGetStringWidth(
+    TexFont * txf,
+    const char *str,
+    int len);
+
+// Lay out multi-line ('\n') text, word wrapped to max_width (0 for no wrapping) and
+// aligned within max_width, or within the widest line when not wrapping
+extern void txfLayoutText(
+    TexFont * txf,
+    const char *string,
+    float max_width,
+    TxfAlign align,
+    TxfLayout * layout);
+
+extern void txfBatchLayout(
+    TxfTextBatch * batch,
+    const TxfLayout * layout,
+    float x, float y);
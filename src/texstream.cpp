@@ -0,0 +1,157 @@
+//
+// Texture streaming: decode on a worker thread, upload within a per-frame byte budget
+//
+#include <stdio.h>
+#include <string.h>
+#include <SDL_image.h>
+#include "texstream.h"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define TEXTURE_STREAM_HAVE_THREADS 1
+#endif
+
+// Decode the image into the staging buffer, rows tightly packed. Runs on the decoding
+// thread, so touches no GL state and publishes the result through stream->state only.
+static int textureStreamDecode(void* data)
+{
+    TextureStream* stream = (TextureStream*)data;
+    SDL_Surface* image = IMG_Load(stream->filename);
+    if (!image)
+    {
+        printf("Failed to load %s, due to %s\n", stream->filename, IMG_GetError());
+        SDL_AtomicSet(&stream->state, TEXTURE_STREAM_FAILED);
+        return 0;
+    }
+
+    // 24 bit images upload as they are, anything else as RGBA
+    if (image->format->BitsPerPixel != 24 && image->format->BitsPerPixel != 32)
+    {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ABGR8888, 0);
+        SDL_FreeSurface(image);
+        image = converted;
+        if (!image)
+        {
+            printf("Failed to convert %s, due to %s\n", stream->filename, SDL_GetError());
+            SDL_AtomicSet(&stream->state, TEXTURE_STREAM_FAILED);
+            return 0;
+        }
+    }
+
+    int bytesPerPixel = image->format->BitsPerPixel / 8;
+    stream->format = bytesPerPixel == 3 ? GL_RGB : GL_RGBA;
+    stream->width = image->w;
+    stream->height = image->h;
+
+    int rowBytes = image->w * bytesPerPixel;
+    stream->staging.resize(rowBytes * image->h);
+    if (SDL_MUSTLOCK(image))
+        SDL_LockSurface(image);
+    for (int row = 0; row < image->h; ++row)
+        memcpy(&stream->staging[row * rowBytes], (const unsigned char*)image->pixels + row * image->pitch, rowBytes);
+    if (SDL_MUSTLOCK(image))
+        SDL_UnlockSurface(image);
+    SDL_FreeSurface(image);
+
+    SDL_AtomicSet(&stream->state, TEXTURE_STREAM_DECODED);
+    return 0;
+}
+
+TextureStream* textureStreamCreate(const char* filename, int flags, unsigned int placeholderColor)
+{
+    TextureStream* stream = new TextureStream();
+    stream->filename = filename;
+    stream->flags = flags;
+    stream->start_ticks = SDL_GetTicks();
+    SDL_AtomicSet(&stream->state, TEXTURE_STREAM_DECODING);
+
+    const unsigned int placeholderPixels[4] = {placeholderColor, placeholderColor, placeholderColor, placeholderColor};
+    textureCreate(&stream->placeholder, 2, 2, GL_RGBA, flags, placeholderPixels);
+
+#ifdef TEXTURE_STREAM_HAVE_THREADS
+    stream->thread = SDL_CreateThread(textureStreamDecode, "textureStreamDecode", stream);
+    if (!stream->thread)
+        printf("INFO: Decoding %s on the main thread, %s\n", filename, SDL_GetError());
+#endif
+    return stream;
+}
+
+// Texture created empty, then filled a band of rows at a time. Mipmaps are
+// generated once the last band is in, not per band.
+static void textureStreamUploadRows(TextureStream* stream, int budgetBytes)
+{
+    if (SDL_AtomicGet(&stream->state) == TEXTURE_STREAM_DECODED)
+    {
+        if (!textureCreate(&stream->texture, stream->width, stream->height, stream->format, stream->flags, NULL))
+        {
+            std::vector<unsigned char>().swap(stream->staging);
+            SDL_AtomicSet(&stream->state, TEXTURE_STREAM_FAILED);
+            return;
+        }
+        stream->texture.flags &= ~(TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS);
+        printf("Image dimensions %dx%d, %d bits per pixel\n", stream->width, stream->height,
+               stream->format == GL_RGB ? 24 : 32);
+        SDL_AtomicSet(&stream->state, TEXTURE_STREAM_UPLOADING);
+    }
+
+    int rowBytes = (int)(stream->staging.size() / stream->height);
+    int rows = budgetBytes / rowBytes;
+    if (rows < 1)
+        rows = 1;
+    if (rows > stream->height - stream->uploaded_rows)
+        rows = stream->height - stream->uploaded_rows;
+    textureUpdate(&stream->texture, 0, stream->uploaded_rows, stream->width, rows,
+                  &stream->staging[stream->uploaded_rows * rowBytes]);
+    stream->uploaded_rows += rows;
+}
+
+bool textureStreamUpdate(TextureStream* stream, int budgetBytes)
+{
+    switch (SDL_AtomicGet(&stream->state))
+    {
+        case TEXTURE_STREAM_DECODING:
+            // Without a thread the decode blocks the main loop. It waits for the next call, as
+            // the frame drawn with the placeholder isn't presented until this one returns.
+            if (stream->thread)
+                return false;
+            if (!stream->decode_deferred)
+            {
+                stream->decode_deferred = true;
+                return false;
+            }
+            textureStreamDecode(stream);
+            return false;
+
+        case TEXTURE_STREAM_DECODED:
+        case TEXTURE_STREAM_UPLOADING:
+            textureStreamUploadRows(stream, budgetBytes);
+            if (stream->uploaded_rows < stream->height)
+                return false;
+
+            // Complete: the texture is still bound, mipmap it and drop the staging copy
+            stream->texture.flags = stream->flags;
+            if (stream->flags & (TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS))
+                glGenerateMipmap(GL_TEXTURE_2D);
+            std::vector<unsigned char>().swap(stream->staging);
+            SDL_AtomicSet(&stream->state, TEXTURE_STREAM_RESIDENT);
+            printf("OK: %s resident after %u ms\n", stream->filename, SDL_GetTicks() - stream->start_ticks);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+GLuint textureStreamTexobj(const TextureStream* stream)
+{
+    SDL_atomic_t* state = (SDL_atomic_t*)&stream->state;
+    return SDL_AtomicGet(state) == TEXTURE_STREAM_RESIDENT ? stream->texture.texobj : stream->placeholder.texobj;
+}
+
+void textureStreamDestroy(TextureStream* stream)
+{
+    if (stream->thread)
+        SDL_WaitThread(stream->thread, NULL);
+    textureDestroy(&stream->texture);
+    textureDestroy(&stream->placeholder);
+    delete stream;
+}
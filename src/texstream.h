@@ -0,0 +1,59 @@
+//
+// Texture streaming: images decoded on a worker thread into a staging buffer, then
+// uploaded a few rows per frame within a byte budget. A placeholder texture stands in
+// until the whole image is resident, and for good if the image fails to load.
+//
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengles2.h>
+
+#include "texture.h"
+
+enum TextureStreamState
+{
+    TEXTURE_STREAM_DECODING,    // Placeholder shown, image being decoded
+    TEXTURE_STREAM_DECODED,     // Staging buffer filled, ready to upload
+    TEXTURE_STREAM_UPLOADING,   // Texture created, rows being uploaded
+    TEXTURE_STREAM_RESIDENT,    // Texture complete, staging buffer freed
+    TEXTURE_STREAM_FAILED       // Image not loaded, placeholder kept
+};
+
+typedef struct {
+    const char* filename;
+    int flags;                  // TextureFlags of the streamed texture
+    Texture texture;
+    Texture placeholder;        // 2x2 of a single color
+    SDL_atomic_t state;         // TextureStreamState, set by the decoding thread up to DECODED
+    SDL_Thread* thread;         // NULL when decoding on the main thread
+    bool decode_deferred;       // Main thread: the first update returned without decoding
+    GLenum format;              // GL_RGB or GL_RGBA, set once DECODED
+    int width;
+    int height;
+    std::vector<unsigned char> staging; // Rows tightly packed, first row first
+    int uploaded_rows;
+    Uint32 start_ticks;         // When streaming started, for the load time printed
+} TextureStream;
+
+// Start loading filename, on a thread where the build has them (native, or Emscripten
+// with -pthread), else in the second textureStreamUpdate, so that the frame drawn with
+// the placeholder is presented first. Creates the placeholder, placeholderColor is its
+// RGBA bytes packed 0xAABBGGRR.
+extern TextureStream* textureStreamCreate(
+    const char* filename,
+    int flags,
+    unsigned int placeholderColor);
+
+// Call once per frame: uploads up to budgetBytes of decoded rows (at least one row).
+// Returns true when the texture to draw with changed.
+extern bool textureStreamUpdate(
+    TextureStream* stream,
+    int budgetBytes);
+
+// The texture to draw with: the streamed texture once resident, else the placeholder
+extern GLuint textureStreamTexobj(
+    const TextureStream* stream);
+
+// Waits for the decoding thread, if still running
+extern void textureStreamDestroy(
+    TextureStream* stream);
@@ -0,0 +1,182 @@
+//
+// Texture creation shared by the samples
+//
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "glstate.h"
+#include "mipmap.h"
+#include "texture.h"
+
+bool textureFullNPOT()
+{
+    static int fullNPOT = -1;
+    if (fullNPOT < 0)
+    {
+        // "OpenGL ES 3.0 ..." natively, "OpenGL ES 3.0 (WebGL 2.0)" in browsers
+        const char* version = (const char*)glGetString(GL_VERSION);
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        fullNPOT = (version && strncmp(version, "OpenGL ES ", 10) == 0 && version[10] >= '3')
+                   || (extensions && strstr(extensions, "GL_OES_texture_npot"));
+        printf("INFO: %s NPOT textures\n", fullNPOT ? "Full" : "Clamped, non mipmapped");
+    }
+    return fullNPOT != 0;
+}
+
+bool textureNPOTAllowed(int flags)
+{
+    return (flags & (TEXTURE_REPEAT | TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS)) == 0 || textureFullNPOT();
+}
+
+int nextPowerOfTwo(int val)
+{
+    int power = 1;
+    while (power < val)
+        power *= 2;
+    return power;
+}
+
+static int bytesPerTexel(GLenum format)
+{
+    switch (format)
+    {
+        case GL_ALPHA:
+        case GL_LUMINANCE:
+            return 1;
+        case GL_LUMINANCE_ALPHA:
+            return 2;
+        case GL_RGB:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+// Next mipmap level's width or height
+static int levelSize(int size)
+{
+    return size > 1 ? size / 2 : 1;
+}
+
+// Texture bytes including the mipmap chain, if any
+static int textureBytes(int width, int height, GLenum format, bool mipmaps)
+{
+    int bytes = 0;
+    for (;;)
+    {
+        bytes += width * height * bytesPerTexel(format);
+        if (!mipmaps || (width == 1 && height == 1))
+            return bytes;
+        width = levelSize(width);
+        height = levelSize(height);
+    }
+}
+
+void textureSetSampler(Texture* texture, int flags)
+{
+    glStateBindTexture(GL_TEXTURE_2D, texture->texobj);
+    bool mipmaps = (flags & (TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS)) != 0 && texture->levels > 1;
+    GLint wrap = (flags & TEXTURE_REPEAT) ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    GLint filter = (flags & TEXTURE_LINEAR) ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+}
+
+// Levels 1 and up of the image, each box filtered from the level above, into the
+// (possibly padded) texture levels
+static void uploadCpuMipmaps(Texture* texture, const unsigned char* pixels)
+{
+    int components = bytesPerTexel(texture->format);
+    int imageWidth = texture->image_width, imageHeight = texture->image_height;
+    int width = texture->width, height = texture->height;
+    std::vector<unsigned char> images[2], zeros;
+    const unsigned char* src = pixels;
+    for (int level = 1; level < texture->levels; ++level)
+    {
+        std::vector<unsigned char>& dst = images[level & 1];
+        dst.resize(levelSize(imageWidth) * levelSize(imageHeight) * components);
+        mipmapDownsample(src, imageWidth, imageHeight, components, &dst[0]);
+        imageWidth = levelSize(imageWidth);
+        imageHeight = levelSize(imageHeight);
+        width = levelSize(width);
+        height = levelSize(height);
+
+        bool exact = width == imageWidth && height == imageHeight;
+        if (!exact)
+            zeros.assign(width * height * components, 0);
+        glTexImage2D(GL_TEXTURE_2D, level, texture->format, width, height, 0,
+                     texture->format, GL_UNSIGNED_BYTE, exact ? &dst[0] : &zeros[0]);
+        if (!exact)
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, imageWidth, imageHeight, texture->format, GL_UNSIGNED_BYTE, &dst[0]);
+        src = &dst[0];
+    }
+}
+
+bool textureCreate(Texture* texture, int width, int height, GLenum format, int flags, const void* pixels)
+{
+    texture->format = format;
+    texture->flags = flags;
+    texture->image_width = width;
+    texture->image_height = height;
+
+    // Exact size when allowed, else the smallest power of 2 texture the image fits in
+    bool mipmaps = (flags & (TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS)) != 0;
+    int potWidth = nextPowerOfTwo(width), potHeight = nextPowerOfTwo(height);
+    bool npot = textureNPOTAllowed(flags);
+    texture->width = npot ? width : potWidth;
+    texture->height = npot ? height : potHeight;
+    texture->levels = mipmaps ? mipmapLevels(texture->width, texture->height) : 1;
+    texture->bytes = textureBytes(texture->width, texture->height, format, mipmaps);
+    texture->bytes_saved = textureBytes(potWidth, potHeight, format, mipmaps) - texture->bytes;
+
+    glGenTextures(1, &texture->texobj);
+    textureSetSampler(texture, flags);
+
+    // Upload the image straight when it fills the texture, else into the padded texture.
+    // Padding is cleared when mipmapped, else it would be filtered into the image's edges.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bool exact = texture->width == width && texture->height == height;
+    std::vector<unsigned char> zeros;
+    if (!exact && mipmaps)
+        zeros.assign(texture->width * texture->height * bytesPerTexel(format), 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, texture->width, texture->height, 0,
+                 format, GL_UNSIGNED_BYTE, exact ? pixels : (zeros.empty() ? NULL : &zeros[0]));
+    if (pixels && !exact)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    if ((flags & TEXTURE_CPU_MIPMAPS) && pixels)
+        uploadCpuMipmaps(texture, (const unsigned char*)pixels);
+    else if (mipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Check for errors
+    GLenum glError = glGetError();
+    if (glError != GL_NO_ERROR)
+    {
+        printf("ERROR: Texture %d (%dx%d) not built, error code %d\n", texture->texobj, texture->width, texture->height, glError);
+        textureDestroy(texture);
+        return false;
+    }
+    printf("OK: Texture %d (%dx%d%s%s) built, %d KB, %d KB saved\n", texture->texobj, texture->width, texture->height,
+           exact ? "" : " padded", mipmaps ? " mipmapped" : "", texture->bytes / 1024, texture->bytes_saved / 1024);
+    return true;
+}
+
+void textureUpdate(Texture* texture, int x, int y, int width, int height, const void* pixels)
+{
+    glStateBindTexture(GL_TEXTURE_2D, texture->texobj);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, texture->format, GL_UNSIGNED_BYTE, pixels);
+    if (texture->flags & (TEXTURE_MIPMAPS | TEXTURE_CPU_MIPMAPS))
+        glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void textureDestroy(Texture* texture)
+{
+    if (texture->texobj != 0)
+    {
+        glStateDeleteTextures(1, &texture->texobj);
+        texture->texobj = 0;
+    }
+}
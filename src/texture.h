@@ -0,0 +1,71 @@
+//
+// Texture creation shared by the samples: exact size non power of 2 (NPOT) textures
+// where the context allows them, else padded to power of 2 dimensions
+//
+#pragma once
+#include <SDL_opengles2.h>
+
+// OpenGL ES 2 / WebGL 1 allow NPOT textures only with clamped wrapping and no
+// mipmaps. OpenGL ES 3 / WebGL 2 and GL_OES_texture_npot lift those limits.
+enum TextureFlags
+{
+    TEXTURE_CLAMP = 0,      // GL_CLAMP_TO_EDGE both ways
+    TEXTURE_REPEAT = 1,     // GL_REPEAT both ways
+    TEXTURE_MIPMAPS = 2,    // Generate mipmaps, sample with GL_LINEAR_MIPMAP_LINEAR (trilinear)
+    TEXTURE_LINEAR = 4,     // GL_LINEAR filtering, else GL_NEAREST
+    TEXTURE_CPU_MIPMAPS = 8 // Mipmaps box filtered on the CPU (see mipmap.h) rather than by
+                            // glGenerateMipmap, when created. Sampled as TEXTURE_MIPMAPS.
+};
+
+typedef struct {
+    GLuint texobj;
+    GLenum format;              // GL_ALPHA, GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB or GL_RGBA
+    int flags;                  // TextureFlags
+    int image_width;            // Texels holding the image, at texel 0,0 (first row first)
+    int image_height;
+    int width;                  // Texels allocated, image size or the next power of 2
+    int height;
+    int levels;                 // Mipmap levels allocated, 1 without mipmaps
+    int bytes;                  // Allocated, mipmaps included
+    int bytes_saved;            // Versus padding to power of 2 dimensions
+} Texture;
+
+// NPOT textures of every kind, queried once from the current GL context
+extern bool textureFullNPOT();
+
+// Whether a texture with flags can be created at its exact size
+extern bool textureNPOTAllowed(
+    int flags);
+
+extern int nextPowerOfTwo(
+    int val);
+
+// Create a texture for a width x height image of tightly packed GL_UNSIGNED_BYTE rows,
+// uploading pixels when not NULL. Texels outside the image are undefined, so keep
+// texture coordinates within image_width / width and image_height / height.
+// Returns false (and prints the GL error) on failure. Leaves the texture bound.
+extern bool textureCreate(
+    Texture * texture,
+    int width, int height,
+    GLenum format,
+    int flags,
+    const void *pixels);
+
+// Set the wrapping and filtering of the texture, bound on return, from flags: wrapping
+// and GL_LINEAR / GL_NEAREST as textureCreate, trilinear if TEXTURE_MIPMAPS or
+// TEXTURE_CPU_MIPMAPS and the texture has mipmaps. The texture's levels are unchanged, so
+// flags without mipmaps select bilinear sampling of a mipmapped texture.
+extern void textureSetSampler(
+    Texture * texture,
+    int flags);
+
+// Replace a width x height region of the image at x,y, rows tightly packed.
+// Leaves the texture bound. Mipmaps are regenerated, by glGenerateMipmap.
+extern void textureUpdate(
+    Texture * texture,
+    int x, int y,
+    int width, int height,
+    const void *pixels);
+
+extern void textureDestroy(
+    Texture * texture);
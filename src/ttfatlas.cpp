@@ -0,0 +1,260 @@
+//
+// Dynamic glyph atlas for TrueType fonts
+//
+#include <stdio.h>
+#include <string.h>
+#include "sdf.h"
+#include "ttfatlas.h"
+
+// Empty texels around each glyph, so filtering never picks up a neighbour
+#define TTF_ATLAS_PADDING 1
+
+TtfAtlas *
+ttfCreateAtlas(TTF_Font * font, int width, int height, int sdf_spread)
+{
+    TexFont *txf = txfCreateFont(width, height, TTF_FontAscent(font), -TTF_FontDescent(font));
+    if (txf == NULL)
+        return NULL;
+    if (sdf_spread > 0)
+    {
+        txf->format = TXF_FORMAT_SDF;
+        txf->sdf_spread = sdf_spread;
+    }
+
+    TtfAtlas *atlas = new TtfAtlas;
+    atlas->font = font;
+    atlas->txf = txf;
+    TtfSkylineNode node = {0, 0, width};
+    atlas->skyline.push_back(node);
+    atlas->dirty_min_row = height;
+    atlas->dirty_max_row = -1;
+    atlas->glyphs_dropped = 0;
+    return atlas;
+}
+
+void
+ttfDestroyAtlas(TtfAtlas * atlas)
+{
+    if (atlas)
+    {
+        txfUnloadFont(atlas->txf);
+        delete atlas;
+    }
+}
+
+// Lowest y a width x height rectangle fits at with its left edge on skyline node i, -1 if none
+static int
+ttfSkylineFit(const TtfAtlas *atlas, int i, int width, int height)
+{
+    const std::vector<TtfSkylineNode>& skyline = atlas->skyline;
+    int x = skyline[i].x;
+    if (x + width > atlas->txf->tex_width)
+        return -1;
+
+    int y = 0;
+    for (int remaining = width; remaining > 0; ++i)
+    {
+        if (skyline[i].y > y)
+            y = skyline[i].y;
+        if (y + height > atlas->txf->tex_height)
+            return -1;
+        remaining -= skyline[i].width;
+    }
+    return y;
+}
+
+// Bottom left skyline packing: place the rectangle as low as possible, then leftmost.
+// Returns 0 when the atlas is full.
+static int
+ttfSkylinePack(TtfAtlas *atlas, int width, int height, int *x, int *y)
+{
+    std::vector<TtfSkylineNode>& skyline = atlas->skyline;
+    int best = -1, bestY = 0;
+    for (int i = 0; i < (int)skyline.size(); ++i)
+    {
+        int fitY = ttfSkylineFit(atlas, i, width, height);
+        if (fitY >= 0 && (best < 0 || fitY < bestY))
+        {
+            best = i;
+            bestY = fitY;
+        }
+    }
+    if (best < 0)
+        return 0;
+
+    *x = skyline[best].x;
+    *y = bestY;
+
+    // Raise the skyline under the rectangle, trimming the nodes it covers
+    TtfSkylineNode node = {*x, bestY + height, width};
+    skyline.insert(skyline.begin() + best, node);
+    for (int i = best + 1; i < (int)skyline.size(); )
+    {
+        int shrink = node.x + node.width - skyline[i].x;
+        if (shrink <= 0)
+            break;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0)
+            break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Merge neighbours at the same height
+    for (int i = 0; i + 1 < (int)skyline.size(); )
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+    return 1;
+}
+
+// Rasterize character c (utf8, len bytes) and add it to the atlas, returns 0 on failure
+static int
+ttfAtlasAddGlyph(TtfAtlas *atlas, unsigned int c, const char *utf8, int len)
+{
+    TexFont *txf = atlas->txf;
+    int minx, maxx, miny, maxy, advance;
+    if (TTF_GlyphMetrics(atlas->font, (Uint16)c, &minx, &maxx, &miny, &maxy, &advance) != 0)
+        return 0;
+
+    // Render the single character: white, opacity in alpha, rows top down with
+    // the baseline at the font ascent, and shifted right by any negative minx
+    char text[8];
+    memcpy(text, utf8, len);
+    text[len] = '\0';
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *surface = TTF_RenderUTF8_Blended(atlas->font, text, white);
+    if (surface == NULL)
+        return 0;
+    SDL_LockSurface(surface);
+
+    // Crop to the covered texels
+    const Uint32 amask = surface->format->Amask;
+    const int ashift = surface->format->Ashift;
+    int left = surface->w, right = -1, top = surface->h, bottom = -1;
+    for (int row = 0; row < surface->h; ++row)
+    {
+        const Uint32 *pixels = (const Uint32 *)((const Uint8 *)surface->pixels + row * surface->pitch);
+        for (int col = 0; col < surface->w; ++col)
+        {
+            if (pixels[col] & amask)
+            {
+                if (col < left) left = col;
+                if (col > right) right = col;
+                if (row < top) top = row;
+                bottom = row;
+            }
+        }
+    }
+
+    // Blank glyphs (space) only need an advance. Distance field glyphs get a
+    // border for their outer field.
+    int width = right >= left ? right - left + 1 : 0;
+    int height = bottom >= top ? bottom - top + 1 : 0;
+    int spread = width > 0 && txf->format == TXF_FORMAT_SDF ? txf->sdf_spread : 0;
+    int cellWidth = width + 2 * spread, cellHeight = height + 2 * spread;
+    int x = 0, y = 0;
+    if (width > 0 &&
+        !ttfSkylinePack(atlas, cellWidth + 2 * TTF_ATLAS_PADDING, cellHeight + 2 * TTF_ATLAS_PADDING, &x, &y))
+    {
+        // Full: keep the advance but draw nothing, rather than rasterizing it again every time
+        if (atlas->glyphs_dropped++ == 0)
+            printf("ttfAtlas: %dx%d atlas full\n", txf->tex_width, txf->tex_height);
+        width = height = cellWidth = cellHeight = spread = 0;
+    }
+    x += TTF_ATLAS_PADDING;
+    y += TTF_ATLAS_PADDING;
+
+    // Coverage goes straight into the texture, or into a scratch cell for the distance field
+    std::vector<unsigned char> cell(spread ? cellWidth * cellHeight : 0);
+    unsigned char *coverage = spread ? &cell[spread * cellWidth + spread] : txf->texstorage + y * txf->tex_width + x;
+    int coverageStride = spread ? cellWidth : txf->tex_width;
+
+    // Texture rows are bottom up, as in .txf files
+    for (int i = 0; i < height; ++i)
+    {
+        const Uint32 *pixels = (const Uint32 *)((const Uint8 *)surface->pixels + (bottom - i) * surface->pitch);
+        unsigned char *texels = coverage + i * coverageStride;
+        for (int j = 0; j < width; ++j)
+            texels[j] = (Uint8)((pixels[left + j] & amask) >> ashift);
+    }
+    if (spread)
+        sdfGenerate(&cell[0], cellWidth, txf->texstorage + y * txf->tex_width + x, txf->tex_width,
+                    cellWidth, cellHeight, spread);
+    if (cellHeight > 0)
+    {
+        if (y < atlas->dirty_min_row)
+            atlas->dirty_min_row = y;
+        if (y + cellHeight - 1 > atlas->dirty_max_row)
+            atlas->dirty_max_row = y + cellHeight - 1;
+    }
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+
+    int xoffset = width > 0 ? left + (minx < 0 ? minx : 0) - spread : 0;
+    int yoffset = height > 0 ? txf->max_ascent - bottom - 1 - spread : 0;
+    return txfAddGlyph(txf, c, x, y, cellWidth, cellHeight, xoffset, yoffset, (float)advance) != NULL;
+}
+
+int
+ttfAtlasAddText(TtfAtlas * atlas, const char *string)
+{
+    int added = 0;
+    const char *end = string + strlen(string);
+    for (const char *s = string; s < end; )
+    {
+        const char *start = s;
+        unsigned int c = txfDecodeUTF8(&s, end);
+
+        // TTF_GlyphMetrics takes 16-bit characters, control characters have no glyph
+        if (c < 0x20 || c > 0xffff)
+            continue;
+        TxfGlyphPage *page = atlas->txf->lut[c / TXF_GLYPH_PAGE_SIZE];
+        if (page && page->glyphs[c % TXF_GLYPH_PAGE_SIZE])
+            continue;
+        if (!TTF_GlyphIsProvided(atlas->font, (Uint16)c))
+            continue;
+        added += ttfAtlasAddGlyph(atlas, c, start, s - start);
+    }
+    return added;
+}
+
+void
+ttfAtlasUpload(TtfAtlas * atlas)
+{
+    TexFont *txf = atlas->txf;
+    if (txf->texobj == 0)
+    {
+        // First upload: the whole (mostly empty) texture
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        txfEstablishTexture(txf, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // Distance fields are interpolated, then thresholded by the shader
+        GLint filter = txf->format == TXF_FORMAT_SDF ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+    else
+    {
+        txfBindFontTexture(txf);
+        if (atlas->dirty_min_row <= atlas->dirty_max_row)
+        {
+            // Only the band of rows holding new glyphs, full width so rows are contiguous
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, atlas->dirty_min_row,
+                            txf->tex_width, atlas->dirty_max_row - atlas->dirty_min_row + 1,
+                            GL_ALPHA, GL_UNSIGNED_BYTE,
+                            txf->texstorage + atlas->dirty_min_row * txf->tex_width);
+        }
+    }
+    atlas->dirty_min_row = txf->tex_height;
+    atlas->dirty_max_row = -1;
+}
@@ -0,0 +1,48 @@
+//
+// Dynamic glyph atlas for TrueType fonts: glyphs are rasterized once with SDL_ttf
+// as text first needs them, skyline packed into a TexFont texture, and uploaded
+// incrementally. Text is then drawn with texfont (txfRenderString, text batches).
+//
+#pragma once
+#include <vector>
+#include <SDL_ttf.h>
+#include "texfont.h"
+
+// Skyline segment: the atlas is free above y from x to x + width
+typedef struct {
+    int x;
+    int y;
+    int width;
+} TtfSkylineNode;
+
+typedef struct {
+    TTF_Font *font;
+    TexFont *txf;                           // Glyph metrics and texels, tex_width x tex_height
+    std::vector<TtfSkylineNode> skyline;    // Left to right, covering the atlas width
+    int dirty_min_row;                      // Texel rows changed since ttfAtlasUpload,
+    int dirty_max_row;                      // empty when min > max
+    int glyphs_dropped;                     // Glyphs that did not fit, drawn blank
+} TtfAtlas;
+
+// Create an empty atlas for font (still owned by the caller) with a
+// width x height alpha texture. With sdf_spread > 0 glyphs are stored as signed
+// distance fields (TXF_FORMAT_SDF) of that spread, to be drawn magnified.
+extern TtfAtlas *ttfCreateAtlas(
+    TTF_Font * font,
+    int width,
+    int height,
+    int sdf_spread);
+
+extern void ttfDestroyAtlas(
+    TtfAtlas * atlas);
+
+// Rasterize and pack the glyphs of UTF-8 string the atlas does not have yet,
+// returns the number of glyphs added
+extern int ttfAtlasAddText(
+    TtfAtlas * atlas,
+    const char *string);
+
+// Upload texels changed since the last upload, creating the texture the first time.
+// Leaves the atlas texture bound.
+extern void ttfAtlasUpload(
+    TtfAtlas * atlas);
@@ -0,0 +1,42 @@
+//
+// Converts a texture font (.txf) to a signed distance field font (TXF_FORMAT_SDF),
+// which stays sharp when text is magnified
+//
+// Build native:
+//     g++ -std=c++11 -O2 txf2sdf.cpp texfont.cpp bitexpand.cpp glstate.cpp sdf.cpp -I<SDL2 include dir> -lGLESv2 -o txf2sdf
+//
+// Run:
+//     ./txf2sdf media/rockfont.txf media/rockfont_sdf.txf 4
+//
+// Result:
+//     The distance field font, spread (default 4) texels either side of glyph edges.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "texfont.h"
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: %s input.txf output.txf [spread]\n", argv[0]);
+        return 1;
+    }
+    int spread = argc > 3 ? atoi(argv[3]) : 4;
+
+    TexFont* txf = txfLoadFont(argv[1]);
+    if (!txf)
+        return 1;
+
+    txfConvertToSDF(txf, spread);
+    int written = txfWriteFont(txf, argv[2]);
+    if (written)
+        printf("%s: %dx%d, %d glyphs, spread %d\n", argv[2], txf->tex_width, txf->tex_height, txf->num_glyphs, spread);
+    else
+        printf("%s: %s\n", argv[2], txfErrorString());
+
+    txfUnloadFont(txf);
+    return written ? 0 : 1;
+}